@@ -0,0 +1,19 @@
+#pragma once
+#include <cstring>
+#include <vector>
+
+// Helpers for the binary files and messages of the library. Values are stored in the native byte order.
+template<typename T> void PutValue(std::vector<unsigned char>& out, const T& value)
+{
+    const unsigned char* bytes = (const unsigned char*)&value;
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// Reads a value at the given position and moves past it. Returns false if there aren't enough bytes left.
+template<typename T> bool GetValue(const std::vector<unsigned char>& data, size_t& pos, T& value)
+{
+    if (pos + sizeof(T) > data.size()) return false;
+    memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <functional>
+
+// Carried by render work so that it can find out, at its checkpoints, that its result is no longer wanted.
+// A default token is never cancelled.
+class CancellationToken
+{
+private:
+    std::function<bool()> isCancelled;
+
+public:
+    CancellationToken() {}
+    explicit CancellationToken(const std::function<bool()>& _isCancelled) : isCancelled(_isCancelled) {}
+
+    bool IsCancelled() const { return isCancelled && isCancelled(); }
+};
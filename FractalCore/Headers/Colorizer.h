@@ -0,0 +1,24 @@
+#pragma once
+#include "FractalKernel.h"
+
+// Everything that defines how iteration results are turned into colors.
+struct ColorParams
+{
+    float hueFg         = 2.26893f; // Fractal hue (customHue.x).
+    float hueBg         = 3.14159f; // Background hue (customHue.y).
+    bool  colorWithZ    = false;
+    int   maxIterations = 500;
+};
+
+// Cpu implementation of the coloring done by the fractal shader.
+class Colorizer
+{
+private:
+    ColorParams params;
+
+public:
+    Colorizer(const ColorParams& _params);
+
+    void ColorizePixel (const FractalSample& sample, unsigned char* rgba);
+    void ColorizePixels(const FractalSample* samples, const int& count, unsigned char* rgba);
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include "Colorizer.h"
+#include "DiskSampleCache.h"
+#include "FractalKernel.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Exports a deep zoom image (name.dzi and name_files/level/column_row.png), a pyramid of png tiles that web viewers
+// like OpenSeadragon can pan and zoom. Only the deepest level is rendered, tile row by tile row. Each upper level is
+// made by downsampling the rows of the level below as they come in, so a level never holds more than the tile row
+// it is filling and the rows it has just been given.
+// Since exports can take hours, the state of the export is periodically saved to name.checkpoint so that an
+// interrupted export can be resumed. Rendering and encoding are deterministic, so a resumed export writes the
+// exact same files as an uninterrupted one. An export can be cancelled from another thread, in which case it stops
+// after the tiles being rendered and saves a checkpoint to resume it from.
+class DeepZoomExporter
+{
+private:
+    struct Level
+    {
+        int width, height;
+        int tileRowsWritten = 0;
+        int pendingRows     = 0;
+        std::vector<unsigned char> pending; // RGBA rows of the tile row being filled.
+    };
+
+    FractalParams      fractalParams;
+    ColorParams        colorParams;
+    int                width, height, tileSize;
+    ThreadPool&        threadPool;
+    std::string        tilesDirectory;
+    std::vector<Level> levels;
+    std::atomic<bool>  success;
+    std::atomic<bool>  cancelled;
+    std::atomic<int>   tileRowsRendered; // Tile rows of the deepest level that went through the whole pyramid.
+    std::chrono::time_point<std::chrono::steady_clock> lastCheckpointTime;
+
+    static std::vector<Level> BuildLevels(const int& fullWidth, const int& fullHeight);
+    bool SaveCheckpoint(const std::string& name);
+
+    void RenderTileRow(const int& tileRow, std::vector<unsigned char>& rows);
+    void WriteTileRow (const int& level, const unsigned char* rows, const int& rowCount, const int& tileRow);
+    void AddRows      (const int& level, const unsigned char* rows, const int& rowCount);
+    void WriteTile    (const int& level, const unsigned char* rows, const int& rowCount, const int& column, const int& tileRow);
+    static void Downsample(const unsigned char* src, const int& srcWidth, const int& srcRows, std::vector<unsigned char>& dst);
+
+public:
+    DeepZoomExporter(const FractalParams& _fractalParams, const ColorParams& _colorParams, const int& _width, const int& _height, ThreadPool& _threadPool, const int& _tileSize = 256);
+
+    double           checkpointInterval = 30.0;    // In seconds.
+    DiskSampleCache* diskCache          = nullptr; // Where the samples of the deepest level's tiles are looked up and kept.
+    TaskPriority     priority           = TaskPriority::Export;
+
+    // Replaces the export parameters and progress by the ones of the given export's checkpoint.
+    // Returns false and leaves the exporter untouched if there is no valid checkpoint.
+    bool LoadCheckpoint(const std::string& name);
+
+    // Takes the progress of the given export's checkpoint if it was saved with the same parameters as this export.
+    // Returns false and leaves the exporter untouched otherwise.
+    bool ResumeCheckpoint(const std::string& name);
+    bool Export(const std::string& name);
+
+    // Makes the export return false once the tiles being rendered are written, with its progress saved.
+    void Cancel() { cancelled = true; }
+
+    bool IsCancelled  () { return cancelled; }
+    int  GetLevelCount() { return (int)levels.size(); }
+    int  GetTileRowCount    () { return (height + tileSize - 1) / tileSize; }
+    int  GetTileRowsRendered() { return tileRowsRendered; }
+    static bool HasCheckpoint(const std::string& name);
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Small deflate encoder (RFC 1951) using LZ77 matching and the fixed huffman codes, shared by the image writers.
+
+// Compresses the given data into a single fixed huffman block followed by a full flush.
+// The output ends on a byte boundary and never references previous blocks, so blocks can be concatenated freely
+// (and compressed in parallel) as long as the stream is ended with a final block.
+void DeflateBlock(const unsigned char* data, const int& size, std::vector<unsigned char>& out);
+
+// Compresses the given data into a complete zlib stream (RFC 1950).
+void ZlibCompress(const unsigned char* data, const int& size, std::vector<unsigned char>& out);
+
+unsigned int UpdateAdler32(unsigned int adler, const unsigned char* data, size_t size);
+unsigned int UpdateCrc32  (unsigned int crc,   const unsigned char* data, const size_t& size);
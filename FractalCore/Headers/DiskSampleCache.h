@@ -0,0 +1,54 @@
+#pragma once
+#include "SampleCache.h"
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Cache of computed regions of samples stored on disk, so that views explored in a previous session (or by another
+// program: the viewer, fractal-render and fractal-server all use the same directory by default) aren't iterated again.
+// Each region is a file named after the hash of its SampleCache key. The full key is stored in the file and checked
+// when reading it, along with a crc, so hash collisions and damaged files are treated as misses.
+// Files are written to a temporary file and renamed, so a crash never leaves a partial entry. The least recently
+// used files are deleted once the directory grows over its byte budget, recency being the file modification time
+// so that it carries over to the next sessions.
+class DiskSampleCache
+{
+private:
+    struct Entry
+    {
+        std::string filename;
+        size_t      byteSize;
+    };
+    std::string      directory;
+    size_t           maxBytes;
+    std::list<Entry> entries; // Most recently used first.
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::mutex       mutex;
+    size_t           usedBytes = 0;
+    size_t           hitCount  = 0, missCount = 0;
+    bool             open      = false;
+
+    std::string GetFilename(const std::string& key);
+    void        Touch      (const std::string& filename, const size_t& byteSize);
+    void        Trim       ();
+
+public:
+    DiskSampleCache(const std::string& _directory, const size_t& _maxBytes);
+
+    SampleCache::Samples Find  (const std::string& key);
+    void                 Insert(const std::string& key, const SampleCache::Samples& samples);
+
+    // Tells if the cache probably holds the key, without reading it or counting a hit or miss.
+    bool Contains(const std::string& key);
+
+    bool   IsOpen       () { return open; }
+    size_t GetUsedBytes () { std::lock_guard<std::mutex> lock(mutex); return usedBytes;      }
+    size_t GetEntryCount() { std::lock_guard<std::mutex> lock(mutex); return entries.size(); }
+    size_t GetHitCount  () { std::lock_guard<std::mutex> lock(mutex); return hitCount;       }
+    size_t GetMissCount () { std::lock_guard<std::mutex> lock(mutex); return missCount;      }
+
+    // Per-user cache directory: %LOCALAPPDATA%\FractalExplorer\SampleCache on Windows,
+    // $XDG_CACHE_HOME/fractal-explorer/samples or ~/.cache/fractal-explorer/samples elsewhere.
+    static std::string GetDefaultDirectory();
+};
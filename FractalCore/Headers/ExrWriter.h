@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum class ExrCompression
+{
+    None = 0,
+    Zip  = 3,
+};
+
+// Writes 32 bit float scanline OpenEXR images, one block of scanlines at a time.
+// Blocks are encoded independently (which can be done in parallel) and must be written in order.
+// The offset table is reserved at the start of the file and filled in when the image is closed.
+class ExrWriter
+{
+private:
+    int                      width, height;
+    ExrCompression           compression;
+    std::vector<std::string> channelNames;
+    std::vector<int>         channelOrder;   // Index in the interleaved pixels of each channel, in file order.
+    std::vector<unsigned long long> blockOffsets;
+    unsigned long long       offsetTablePos = 0, fileSize = 0;
+    FILE*                    file     = nullptr;
+    bool                     inMemory = false;
+    std::vector<unsigned char> output;
+
+    void WriteHeader();
+    void Append(const unsigned char* data, const size_t& size);
+
+public:
+    ExrWriter(const int& _width, const int& _height, const std::vector<std::string>& _channelNames, const ExrCompression& _compression);
+    ~ExrWriter();
+
+    bool Open(const char* filename);
+    void OpenInMemory();
+    bool Close();
+
+    int  GetLinesPerBlock() { return compression == ExrCompression::Zip ? 16 : 1; }
+    int  GetBlockCount()    { return (height + GetLinesPerBlock() - 1) / GetLinesPerBlock(); }
+
+    // Encodes the given block from pixels holding one float per channel (in constructor order) for each pixel.
+    void EncodeBlock(const int& block, const float* pixels, std::vector<unsigned char>& encoded);
+    void WriteBlock (const std::vector<unsigned char>& encoded);
+
+    const std::vector<unsigned char>& GetData() { return output; }
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include "CancellationToken.h"
+#include "FractalTypes.h"
+
+// Type of the numbers used to iterate the fractal. Single precision is what the shader uses.
+enum class FloatPrecision
+{
+    Single,
+    Double,
+};
+
+// Everything that defines which point of the complex plane each pixel shows and how it is iterated.
+struct FractalParams
+{
+    FractalTypes   fractal       = FractalTypes::MandelbrotSet;
+    bool           juliaSet      = false;
+    double         scale         = 0;                // Zoom level, the view is magnified by 2^scale.
+    double         offsetX       = 0, offsetY = 0;
+    double         complexCX     = 0, complexCY = 0; // Julia set constant, with the sine automation already applied.
+    double         viewWidth     = 1920;             // Size of the viewport the parameters were chosen in, which
+    double         viewHeight    = 1080;             // defines the framing of the image whatever its resolution.
+    int            maxIterations = 500;
+    FloatPrecision precision     = FloatPrecision::Double;
+};
+
+// Result of the iteration of one pixel.
+struct FractalSample
+{
+    float iterations;       // Number of iterations before the point escaped (maxIterations if it didn't).
+    float smoothIterations; // Continuous version of the iteration count, for banding-free coloring.
+    float zRe, zIm;         // Final value of z.
+};
+
+// Iteration of a point that was stopped before it was done, so that it can be resumed later. z and the number of
+// iterations are all it takes, the rest is computed again from the position of the point.
+struct PointIteration
+{
+    double zRe = 0, zIm = 0;
+    int    iterations = 0;
+};
+
+// Cpu implementation of the fractal shader (Shaders/Fractal.frag), computed in single or double precision.
+class FractalKernel
+{
+private:
+    FractalParams params;
+    int           width, height;
+
+public:
+    FractalKernel(const FractalParams& _params, const int& _width, const int& _height);
+
+    // Computes the point at the given position, in pixels from the top left corner of the image.
+    FractalSample ComputeSample(const double& x, const double& y);
+    FractalSample ComputePixel (const int& x, const int& y);
+
+    // Same as ComputeSample, iterating at most maxSteps more times from the given state, which is updated. Returns
+    // true with the sample once the point escaped or reached the maximum iterations, false if it must be continued.
+    bool ContinueSample(const double& x, const double& y, PointIteration& state, const int& maxSteps, FractalSample& out);
+
+    // The token is checked before each row. Returns the number of rows computed, which is less than asked for if the
+    // work was cancelled, in which case the remaining rows are left untouched.
+    int ComputeRows  (const int& firstRow, const int& rowCount, FractalSample* out, const CancellationToken& cancel = CancellationToken());
+    int ComputeRegion(const int& x, const int& y, const int& regionWidth, const int& regionHeight, FractalSample* out, const CancellationToken& cancel = CancellationToken());
+};
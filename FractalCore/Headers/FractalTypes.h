@@ -0,0 +1,22 @@
+#pragma once
+
+#define FRACTAL_COUNT 5
+enum class FractalTypes
+{
+    MandelbrotSet,
+    BurningShip,
+    CrescentMoon,
+    NorthStar,
+    LoversFractal,
+};
+FractalTypes operator++(FractalTypes& type);
+FractalTypes operator--(FractalTypes& type);
+
+class FractalNames
+{
+public:
+    static const char* names[FRACTAL_COUNT];
+
+    // Finds the fractal with the given name or index. Case, spaces and punctuation are ignored.
+    static bool Parse(const char* name, FractalTypes& type);
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include "FractalKernel.h"
+#include <chrono>
+
+// Iterates the points of an image one after the other in slices that each end by a deadline, for the work that has to
+// share a thread with the frames, like on the web where there are no workers. The point being iterated when a slice
+// runs out keeps its state and is resumed by the next slice, so a slice never runs over its deadline by more than a
+// few iterations, however many iterations the points take.
+class IterationSlicer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    static const int stepsPerCheck  = 256; // Iterations of a point between two looks at the clock.
+    static const int pointsPerCheck = 16;  // Points done between two looks at the clock.
+
+    int            pointCount;
+    int            nextPoint = 0;
+    PointIteration pending;   // State of the next point, which the last slice may have started.
+
+public:
+    IterationSlicer(const int& _pointCount = 0) : pointCount(_pointCount) {}
+
+    // Starts over with the given number of points.
+    void Restart(const int& _pointCount) { pointCount = _pointCount; nextPoint = 0; pending = PointIteration(); }
+
+    // Iterates the next points until the deadline. locate(index, x, y) returns the kernel of a point and sets its
+    // position in the kernel's image, store(index, sample) is called once the point is done. Returns true once all
+    // the points are done.
+    template<typename Locate, typename Store> bool Run(const Clock::time_point& deadline, const Locate& locate, const Store& store)
+    {
+        int pointsSinceCheck = 0;
+        while (nextPoint < pointCount)
+        {
+            double        x, y;
+            FractalSample sample;
+            FractalKernel& kernel = locate(nextPoint, x, y);
+            while (!kernel.ContinueSample(x, y, pending, stepsPerCheck, sample))
+                if (Clock::now() >= deadline)
+                    return false;
+            store(nextPoint, sample);
+            pending = PointIteration();
+            nextPoint++;
+
+            if (++pointsSinceCheck == pointsPerCheck) {
+                pointsSinceCheck = 0;
+                if (Clock::now() >= deadline)
+                    break;
+            }
+        }
+        return IsDone();
+    }
+
+    bool IsDone       () { return nextPoint >= pointCount; }
+    int  GetNextPoint () { return nextPoint;  }
+    int  GetPointCount() { return pointCount; }
+};
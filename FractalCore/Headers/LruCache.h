@@ -0,0 +1,131 @@
+#pragma once
+#include "MemoryBudget.h"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Thread-safe in-memory cache of immutable values, evicting the least recently used ones once the cache grows over
+// its byte budget. Values are shared, so evicting one doesn't invalidate it for the threads still using it.
+// The cache can also be charged to a memory budget, which then evicts entries when the process runs short of memory.
+template<typename T> class LruCache
+{
+public:
+    using Value = std::shared_ptr<const T>;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        Value       value;
+        size_t      byteSize;
+    };
+    std::list<Entry> entries; // Most recently used first.
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index;
+    std::mutex       mutex;
+    size_t           maxBytes;
+    size_t           usedBytes = 0;
+    size_t           hitCount  = 0, missCount = 0;
+    MemoryBudget*    memoryBudget  = nullptr;
+    int              budgetAccount = -1;
+
+    // Returns the bytes freed.
+    size_t Remove(const typename std::list<Entry>::iterator& entry)
+    {
+        const size_t byteSize = entry->byteSize;
+        usedBytes -= byteSize;
+        index.erase(entry->key);
+        entries.erase(entry);
+        return byteSize;
+    }
+
+    // Entries are charged before they are added and credited once removed, so that the account never falls below what
+    // the cache holds. Called without the mutex locked, since the budget may call back into Trim.
+    void Charge(const size_t& bytes) { if (memoryBudget && bytes > 0) memoryBudget->Charge(budgetAccount, bytes); }
+    void Credit(const size_t& bytes) { if (memoryBudget && bytes > 0) memoryBudget->Credit(budgetAccount, bytes); }
+
+public:
+    LruCache(const size_t& _maxBytes) : maxBytes(_maxBytes) {}
+    ~LruCache()
+    {
+        if (memoryBudget)
+            memoryBudget->Unregister(budgetAccount);
+    }
+
+    // Charges the entries of the cache to an account of the given budget, which can then evict them.
+    // Must be called before the cache is used.
+    void SetMemoryBudget(MemoryBudget* _memoryBudget, const std::string& accountName)
+    {
+        memoryBudget  = _memoryBudget;
+        budgetAccount = memoryBudget->Register(accountName, [this](const size_t& bytes)
+        {
+            const size_t used = GetUsedBytes();
+            Trim(used > bytes ? used - bytes : 0);
+        });
+    }
+
+    Value Find(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found == index.end()) {
+            missCount++;
+            return nullptr;
+        }
+
+        // Move the entry to the front of the list.
+        entries.splice(entries.begin(), entries, found->second);
+        hitCount++;
+        return found->second->value;
+    }
+
+    // Tells if the cache holds the key, without counting a hit or miss or changing the order of the entries.
+    bool Contains(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index.count(key) > 0;
+    }
+
+    void Insert(const std::string& key, const Value& value, const size_t& byteSize)
+    {
+        if (!value || byteSize > maxBytes)
+            return;
+
+        Charge(byteSize);
+        size_t freedBytes = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = index.find(key);
+            if (found != index.end())
+                freedBytes += Remove(found->second);
+
+            // Evict the least recently used entries until the new one fits.
+            while (!entries.empty() && usedBytes + byteSize > maxBytes)
+                freedBytes += Remove(std::prev(entries.end()));
+
+            entries.push_front({ key, value, byteSize });
+            index[key] = entries.begin();
+            usedBytes += byteSize;
+        }
+        Credit(freedBytes);
+    }
+
+    // Evicts entries until the cache holds at most the given number of bytes.
+    void Trim(const size_t& bytes)
+    {
+        size_t freedBytes = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!entries.empty() && usedBytes > bytes)
+                freedBytes += Remove(std::prev(entries.end()));
+        }
+        Credit(freedBytes);
+    }
+
+    size_t GetUsedBytes () { std::lock_guard<std::mutex> lock(mutex); return usedBytes;      }
+    size_t GetEntryCount() { std::lock_guard<std::mutex> lock(mutex); return entries.size(); }
+    size_t GetHitCount  () { std::lock_guard<std::mutex> lock(mutex); return hitCount;       }
+    size_t GetMissCount () { std::lock_guard<std::mutex> lock(mutex); return missCount;      }
+};
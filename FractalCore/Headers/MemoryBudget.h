@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Keeps the memory of the subsystems that register with it under a ceiling. Each subsystem charges its large buffers
+// to its account when it allocates them and credits them back when it frees them. Accounts holding memory that can
+// be given back, like caches and pools, have a reclaimer. When a charge takes the total over the ceiling, the budget
+// asks the reclaimers, in registration order, to free what is over. Buffers that can be made smaller, like the bands
+// of an export, ask how much room there is before they are allocated.
+// With a ceiling of 0, memory is only counted.
+class MemoryBudget
+{
+public:
+    // Frees about the given number of bytes if possible. The freed memory is credited back by the account's owner.
+    using Reclaimer = std::function<void(const size_t& bytes)>;
+
+private:
+    struct Account
+    {
+        std::string name;
+        size_t      bytes = 0, peakBytes = 0;
+        Reclaimer   reclaimer;
+        bool        registered = true;
+    };
+    std::vector<Account> accounts; // By id, ids of unregistered accounts aren't reused.
+    std::mutex           mutex;
+    std::mutex           reclaimMutex; // Reclaimers run one at a time, without the main mutex locked.
+    size_t               ceiling;
+    size_t               usedBytes      = 0, peakBytes = 0;
+    size_t               reclaimedBytes = 0;
+
+public:
+    MemoryBudget(const size_t& _ceiling = 0) : ceiling(_ceiling) {}
+
+    // Returns the id of a new account. The reclaimer, if any, must stay valid until the account is unregistered.
+    int  Register  (const std::string& name, const Reclaimer& reclaimer = nullptr);
+    void Unregister(const int& account);
+
+    // Charges never fail, the allocation already happened. Charges that go over the ceiling reclaim memory.
+    void Charge(const int& account, const size_t& bytes);
+    void Credit(const int& account, const size_t& bytes);
+
+    // Reclaims memory until the given number of bytes fits under the ceiling, or until nothing more can be reclaimed.
+    // Returns the number of bytes that fit, at most the wanted number.
+    size_t MakeRoom(const size_t& wanted);
+
+    void   SetCeiling(const size_t& _ceiling);
+    size_t GetCeiling();
+    size_t GetUsedBytes();
+    size_t GetPeakBytes();
+    size_t GetReclaimedBytes();
+    // One line per account: its name, current and peak bytes.
+    std::string GetReport();
+
+    // Resident memory of the whole process as reported by the system, 0 where it isn't known.
+    static size_t GetResidentBytes();
+};
+
+// Charges a buffer to an account for as long as it lives. Does nothing without a budget.
+class ScopedCharge
+{
+private:
+    MemoryBudget* budget;
+    int           account;
+    size_t        bytes;
+
+public:
+    ScopedCharge(MemoryBudget* _budget, const int& _account, const size_t& _bytes) : budget(_budget), account(_account), bytes(_bytes)
+    {
+        if (budget) budget->Charge(account, bytes);
+    }
+    ~ScopedCharge()
+    {
+        if (budget) budget->Credit(account, bytes);
+    }
+    ScopedCharge(const ScopedCharge&) = delete;
+    ScopedCharge& operator=(const ScopedCharge&) = delete;
+};
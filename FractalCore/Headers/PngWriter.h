@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdio>
+#include <vector>
+
+// Encodes an RGBA png image block of rows by block of rows, so that large images never need to be held in memory.
+// Each block of rows is deflated independently and ends with a full flush, which makes it its own IDAT chunk.
+class PngWriter
+{
+private:
+    int          width, height;
+    int          rowsWritten = 0;
+    unsigned int adler       = 1;
+    FILE*        file        = nullptr;
+    bool         inMemory    = false;
+    std::vector<unsigned char> output;
+    std::vector<unsigned char> prevRow, filtered;
+
+    void FilterRow(const unsigned char* row, unsigned char* dst);
+    void WriteChunk(const char* type, const unsigned char* data, const size_t& size);
+    void FlushOutput();
+
+public:
+    PngWriter(const int& _width, const int& _height);
+    ~PngWriter();
+
+    bool Open(const char* filename);
+    void OpenInMemory();
+    void WriteRows(const unsigned char* firstRow, const int& rowCount, const int& rowStride);
+    bool Close();
+
+    int  GetRowsWritten() { return rowsWritten; }
+    const std::vector<unsigned char>& GetData() { return output; }
+};
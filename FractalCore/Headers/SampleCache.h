@@ -0,0 +1,23 @@
+#pragma once
+#include "FractalKernel.h"
+#include "LruCache.h"
+#include <string>
+#include <vector>
+
+// In-memory cache of computed regions of samples, so that views rendered again (with other colors, other file
+// formats...) don't have to be iterated again.
+class SampleCache : public LruCache<std::vector<FractalSample>>
+{
+public:
+    using Samples = Value;
+
+    SampleCache(const size_t& _maxBytes) : LruCache(_maxBytes) {}
+
+    void Insert(const std::string& key, const Samples& samples) { LruCache::Insert(key, samples, samples->size() * sizeof(FractalSample)); }
+
+    // Returns a key that only depends on what affects the samples of the given region of an image.
+    static std::string MakeKey(const FractalParams& params, const int& imageWidth, const int& imageHeight, const int& x, const int& y, const int& regionWidth, const int& regionHeight);
+
+    // 64 bits FNV-1a hash of a key, for when a shorter name is needed.
+    static unsigned long long HashKey(const std::string& key);
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Blocking tcp socket, closed when destroyed. Sockets can be moved but not copied.
+class Socket
+{
+private:
+    intptr_t handle = -1;
+
+    explicit Socket(const intptr_t& _handle) : handle(_handle) {}
+
+public:
+    Socket() {}
+    Socket(Socket&& other) : handle(other.handle) { other.handle = -1; }
+    Socket& operator=(Socket&& other);
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+    ~Socket() { Close(); }
+
+    // Connects to the given host name or address. Returns an invalid socket on failure.
+    static Socket Connect(const std::string& host, const int& port);
+    // Listens on the given local address. Returns an invalid socket on failure.
+    static Socket Listen (const std::string& address, const int& port);
+    Socket Accept();
+
+    // Sends or receives exactly the given number of bytes. Returns false if the connection failed or timed out.
+    bool SendAll   (const void* data, const size_t& size);
+    bool ReceiveAll(void* data, const size_t& size);
+    // Receives what is available, up to size bytes. Returns the number of bytes received, 0 or less on failure.
+    int  Receive   (void* data, const size_t& size);
+
+    // Returns true if the other end closed the connection, without waiting or consuming any received data.
+    bool IsPeerClosed();
+    // Waits until something can be received, or the connection closed, for at most the given time. Returns false
+    // if the time ran out.
+    bool WaitForData(const int& milliseconds);
+
+    void SetReceiveTimeout(const int& seconds);
+    void SetNoDelay();
+    void Close();
+    bool IsValid() { return handle >= 0; }
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Scheduling classes, from the most to the least urgent.
+enum class TaskPriority
+{
+    Interactive, // What the user is looking at.
+    Prefetch,    // What the user is likely to look at next.
+    Export,      // Exports the user started and is waiting for.
+    Batch,       // Queued renders nobody is watching.
+};
+
+// Runs tasks on a fixed set of worker threads.
+// The web build has no threads, so its pool has no workers and tasks run on the thread that waits for them.
+// The most urgent queued task runs first. A ParallelFor task steps aside between two items whenever a more urgent
+// task is queued, and the rest of its items run once the urgent work is done. So that less urgent work still
+// finishes under a steady stream of urgent work, a class that was passed over shareInterval times in a row gets
+// to run one task or item.
+class ThreadPool
+{
+private:
+    static const int priorityCount = 4;
+    static const int shareInterval = 8;
+
+    std::vector<std::thread>          workers;
+    std::deque<std::function<void()>> tasks[priorityCount];
+    int                               passedOver[priorityCount] = { 0 };
+    size_t                            preemptionCount = 0;
+    std::mutex                        mutex;
+    std::condition_variable           taskAvailable;
+    bool                              stopping = false;
+
+    // These three expect the mutex to be locked.
+    int  GetNextPriority(const int& running = -1);
+    void TakeTurn(const int& priority);
+    bool PopTask(std::function<void()>& task, const int& lowest = priorityCount - 1);
+
+    void WorkerLoop();
+    bool RunNextTask(const TaskPriority& lowest);
+    bool Preempt(const TaskPriority& priority, const std::function<void()>& task);
+
+public:
+    ThreadPool(int threadCount = -1);
+    ~ThreadPool();
+
+    void   Submit(const std::function<void()>& task, const TaskPriority& priority = TaskPriority::Interactive);
+    void   ParallelFor(const int& count, const std::function<void(int)>& func, const TaskPriority& priority = TaskPriority::Interactive);
+    int    GetThreadCount() { return workers.empty() ? 1 : (int)workers.size(); }
+    size_t GetPreemptionCount();
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include "Colorizer.h"
+#include "FractalKernel.h"
+#include "FractalTypes.h"
+
+// Pair of floats with the same layout as raylib's Vector2, so that view values can be sent to shaders as they are.
+struct Float2
+{
+    float x, y;
+};
+
+// Everything the user can change about what is shown: the fractal, the part of it that is visible and its colors.
+struct ViewState
+{
+    float        scale          =   0.f;
+    Float2       offset         = { 0.f, 0.f };
+    Float2       complexC       = { -1.35f, 0.05f };
+    Float2       customHue      = { 2.26893f, 3.14159f };
+    Float2       sineParams     = { 1.f, 0.f };
+    FractalTypes curFractal     = FractalTypes::MandelbrotSet;
+    bool         renderJuliaSet = false;
+    bool         colorPxWithZ   = false;
+
+    // Returns the parameters to render this view at the given time (in seconds, for the sine automation),
+    // framed like it is in a viewport of the given size.
+    FractalParams GetFractalParams(const double& time, const double& viewWidth, const double& viewHeight) const;
+    ColorParams   GetColorParams() const;
+};
@@ -0,0 +1,99 @@
+#include "Colorizer.h"
+#include <cmath>
+
+// Function used only in HSVtoRGB to convert from hsv to rgb.
+static float ColorConversion(const float& v, const float& s, float k)
+{
+    float t = 4.f - k;
+    k = t < k ? t : k;
+    k = k < 1.f ? k : 1.f;
+    k = k > 0.f ? k : 0.f;
+    return v - v * s * k;
+}
+
+// GLSL's mod, which is always positive for a positive divisor.
+static float GlslMod(const float& x, const float& y)
+{
+    return x - y * floorf(x / y);
+}
+
+// Converts hsv to rgb with the hue in [0, 6[, like the shader does.
+static void HSVtoRGB(const float& h, const float& s, const float& v, float* rgb)
+{
+    rgb[0] = ColorConversion(v, s, GlslMod(5.f + h, 6.f));
+    rgb[1] = ColorConversion(v, s, GlslMod(3.f + h, 6.f));
+    rgb[2] = ColorConversion(v, s, GlslMod(1.f + h, 6.f));
+}
+
+// Splits the given float in scientific notation (x: val, y: exponent), like the shader's scFloatCreate.
+static void ScFloatCreate(float val, int exponent, float& outVal, float& outExponent)
+{
+    for (int i = 0; i < 1000 && fabsf(val) > 100.f; i++) {
+        val /= 10.f;
+        exponent++;
+    }
+    for (int i = 0; i < 1000 && fabsf(val) < 1.f && val != 0.f; i++) {
+        val *= 10.f;
+        exponent--;
+    }
+    outVal      = val;
+    outExponent = (float)exponent;
+}
+
+// Converts a color channel to 8 bits like the gpu does when writing to a rendertexture.
+static unsigned char ToByte(const float& value)
+{
+    if (!(value > 0.f)) return 0;
+    if (value >= 1.f)   return 255;
+    return (unsigned char)(value * 255.f + 0.5f);
+}
+
+
+Colorizer::Colorizer(const ColorParams& _params)
+    : params(_params)
+{
+}
+
+void Colorizer::ColorizePixel(const FractalSample& sample, unsigned char* rgba)
+{
+    float rgb[3] = { 0.f, 0.f, 0.f };
+    if (!params.colorWithZ)
+    {
+        // Color the pixel in function of the number of iterations: black, then the fractal hue, then the background hue.
+        if (sample.iterations < params.maxIterations)
+        {
+            float lerpVal = 1.f - sample.iterations / params.maxIterations;
+            if (lerpVal < 0.5f) {
+                float t = lerpVal * 2.f;
+                HSVtoRGB(params.hueFg * t, t, 1.f, rgb);
+            }
+            else {
+                float t = lerpVal * 2.f - 1.f;
+                HSVtoRGB(params.hueFg + (params.hueBg - params.hueFg) * t, 1.f, 1.f - t, rgb);
+            }
+        }
+    }
+    else
+    {
+        // Color the pixel in function of z's value and exponent.
+        float zxVal, zxExponent, zyVal, zyExponent;
+        ScFloatCreate(sample.zRe, 0, zxVal, zxExponent);
+        ScFloatCreate(sample.zIm, 0, zyVal, zyExponent);
+        float mixX = (fabsf(zxExponent) / 2.f + 1.f / zxVal) * 0.5f;
+        float mixY = (fabsf(zyExponent) / 2.f + 1.f / zyVal) * 0.5f;
+        rgb[0] = mixX;
+        rgb[1] = (mixX + mixY) * 0.5f;
+        rgb[2] = mixY;
+    }
+
+    rgba[0] = ToByte(rgb[0]);
+    rgba[1] = ToByte(rgb[1]);
+    rgba[2] = ToByte(rgb[2]);
+    rgba[3] = 255;
+}
+
+void Colorizer::ColorizePixels(const FractalSample* samples, const int& count, unsigned char* rgba)
+{
+    for (int i = 0; i < count; i++)
+        ColorizePixel(samples[i], rgba + i * 4);
+}
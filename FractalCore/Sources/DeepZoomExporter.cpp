@@ -0,0 +1,363 @@
+#include "DeepZoomExporter.h"
+#include "BinaryIO.h"
+#include "Deflate.h"
+#include "PngWriter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+DeepZoomExporter::DeepZoomExporter(const FractalParams& _fractalParams, const ColorParams& _colorParams, const int& _width, const int& _height, ThreadPool& _threadPool, const int& _tileSize)
+    : fractalParams(_fractalParams), colorParams(_colorParams), width(_width), height(_height), tileSize(_tileSize), threadPool(_threadPool), success(true), cancelled(false), tileRowsRendered(0)
+{
+    levels = BuildLevels(width, height);
+}
+
+std::vector<DeepZoomExporter::Level> DeepZoomExporter::BuildLevels(const int& fullWidth, const int& fullHeight)
+{
+    // Level 0 is a single pixel and each level doubles the size of the previous one, up to the full image.
+    std::vector<Level> result;
+    int levelWidth = fullWidth, levelHeight = fullHeight;
+    while (true)
+    {
+        Level level;
+        level.width  = levelWidth;
+        level.height = levelHeight;
+        result.insert(result.begin(), level);
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        levelWidth  = (levelWidth  + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+    return result;
+}
+
+bool DeepZoomExporter::Export(const std::string& name)
+{
+    // Create the tile directories.
+    tilesDirectory = name + "_files/";
+    for (int level = 0; level < GetLevelCount(); level++) {
+        std::error_code error;
+        std::filesystem::create_directories(tilesDirectory + std::to_string(level), error);
+        if (error)
+            return false;
+    }
+
+    // Write the descriptor.
+    FILE* descriptor = fopen((name + ".dzi").c_str(), "w");
+    if (!descriptor)
+        return false;
+    fprintf(descriptor, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(descriptor, "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"png\" Overlap=\"0\" TileSize=\"%d\">\n", tileSize);
+    fprintf(descriptor, "    <Size Width=\"%d\" Height=\"%d\"/>\n", width, height);
+    fprintf(descriptor, "</Image>\n");
+    success = fclose(descriptor) == 0;
+
+    // Render the deepest level one tile row at a time and feed each tile row to the level above.
+    // When resuming, the tile rows saved in the checkpoint are skipped and the ones written after it are overwritten.
+    const int deepestLevel = GetLevelCount() - 1;
+    const int tileRowCount = GetTileRowCount();
+    std::vector<unsigned char> rows, downsampled;
+    lastCheckpointTime = std::chrono::steady_clock::now();
+    for (int tileRow = tileRowsRendered; tileRow < tileRowCount && success && !cancelled; tileRow++)
+    {
+        // A tile row cut short by a cancellation isn't passed on, it is rendered again when the export is resumed.
+        RenderTileRow(tileRow, rows);
+        if (cancelled)
+            break;
+        const int rowCount = (int)(rows.size() / ((size_t)width * 4));
+        if (deepestLevel > 0) {
+            Downsample(rows.data(), width, rowCount, downsampled);
+            AddRows(deepestLevel - 1, downsampled.data(), (rowCount + 1) / 2);
+        }
+        tileRowsRendered = tileRow + 1;
+
+        // Save the progress once in a while.
+        std::chrono::duration<double> timeSinceCheckpoint = std::chrono::steady_clock::now() - lastCheckpointTime;
+        if (success && tileRowsRendered < tileRowCount && timeSinceCheckpoint.count() >= checkpointInterval) {
+            SaveCheckpoint(name);
+            lastCheckpointTime = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Save the progress of a cancelled export so that it can be resumed.
+    if (cancelled && tileRowsRendered < tileRowCount) {
+        if (success)
+            SaveCheckpoint(name);
+        return false;
+    }
+
+    // The checkpoint is kept if the export failed, so that it can be resumed once the problem is fixed.
+    if (success) {
+        std::error_code removeError;
+        std::filesystem::remove(name + ".checkpoint", removeError);
+    }
+    return success;
+}
+
+void DeepZoomExporter::RenderTileRow(const int& tileRow, std::vector<unsigned char>& rows)
+{
+    const int firstRow = tileRow * tileSize;
+    const int rowCount = std::min(tileSize, height - firstRow);
+    rows.resize((size_t)width * rowCount * 4);
+
+    // Each tile is rendered and encoded by its own task.
+    FractalKernel kernel(fractalParams, width, height);
+    Colorizer     colorizer(colorParams);
+    const int columnCount = (width + tileSize - 1) / tileSize;
+    threadPool.ParallelFor(columnCount, [&](int column)
+    {
+        if (cancelled)
+            return;
+        const int firstColumn = column * tileSize;
+        const int tileWidth   = std::min(tileSize, width - firstColumn);
+        const std::string key = diskCache ? SampleCache::MakeKey(fractalParams, width, height, firstColumn, firstRow, tileWidth, rowCount) : "";
+        SampleCache::Samples samples = diskCache ? diskCache->Find(key) : nullptr;
+        if (!samples) {
+            auto computed = std::make_shared<std::vector<FractalSample>>((size_t)tileWidth * rowCount);
+            kernel.ComputeRegion(firstColumn, firstRow, tileWidth, rowCount, computed->data());
+            if (diskCache)
+                diskCache->Insert(key, computed);
+            samples = computed;
+        }
+        for (int y = 0; y < rowCount; y++)
+            colorizer.ColorizePixels(samples->data() + (size_t)y * tileWidth, tileWidth, rows.data() + ((size_t)y * width + firstColumn) * 4);
+        WriteTile(GetLevelCount() - 1, rows.data(), rowCount, column, tileRow);
+    }, priority);
+}
+
+void DeepZoomExporter::AddRows(const int& levelIndex, const unsigned char* rows, const int& rowCount)
+{
+    // Append the rows to the tile row being filled. Rows always come in halves of tile rows, so they never overflow it.
+    Level& level = levels[levelIndex];
+    const size_t rowSize = (size_t)level.width * 4;
+    level.pending.resize(rowSize * (level.pendingRows + rowCount));
+    memcpy(level.pending.data() + rowSize * level.pendingRows, rows, rowSize * rowCount);
+    level.pendingRows += rowCount;
+
+    // Write the tile row once it is full or the level is done, then pass it on to the level above.
+    const bool lastRows = level.tileRowsWritten * tileSize + level.pendingRows >= level.height;
+    if (level.pendingRows < tileSize && !lastRows)
+        return;
+
+    WriteTileRow(levelIndex, level.pending.data(), level.pendingRows, level.tileRowsWritten);
+    if (levelIndex > 0) {
+        std::vector<unsigned char> downsampled;
+        Downsample(level.pending.data(), level.width, level.pendingRows, downsampled);
+        AddRows(levelIndex - 1, downsampled.data(), (level.pendingRows + 1) / 2);
+    }
+    level.tileRowsWritten++;
+    level.pendingRows = 0;
+    level.pending.clear();
+}
+
+void DeepZoomExporter::WriteTileRow(const int& level, const unsigned char* rows, const int& rowCount, const int& tileRow)
+{
+    const int columnCount = (levels[level].width + tileSize - 1) / tileSize;
+    threadPool.ParallelFor(columnCount, [&](int column)
+    {
+        WriteTile(level, rows, rowCount, column, tileRow);
+    }, priority);
+}
+
+void DeepZoomExporter::WriteTile(const int& level, const unsigned char* rows, const int& rowCount, const int& column, const int& tileRow)
+{
+    const int levelWidth = levels[level].width;
+    const int tileWidth  = std::min(tileSize, levelWidth - column * tileSize);
+    const std::string filename = tilesDirectory + std::to_string(level) + "/" + std::to_string(column) + "_" + std::to_string(tileRow) + ".png";
+
+    PngWriter png(tileWidth, rowCount);
+    if (!png.Open(filename.c_str())) {
+        success = false;
+        return;
+    }
+    png.WriteRows(rows + (size_t)column * tileSize * 4, rowCount, levelWidth * 4);
+    if (!png.Close())
+        success = false;
+}
+
+void DeepZoomExporter::Downsample(const unsigned char* src, const int& srcWidth, const int& srcRows, std::vector<unsigned char>& dst)
+{
+    // Average each 2x2 block of pixels. The last row and column only average what there is when the size is odd.
+    const int dstWidth = (srcWidth + 1) / 2, dstRows = (srcRows + 1) / 2;
+    dst.resize((size_t)dstWidth * dstRows * 4);
+    for (int y = 0; y < dstRows; y++)
+    {
+        const int rowsY = (2*y + 1 < srcRows) ? 2 : 1;
+        for (int x = 0; x < dstWidth; x++)
+        {
+            const int columnsX = (2*x + 1 < srcWidth) ? 2 : 1;
+            for (int channel = 0; channel < 4; channel++)
+            {
+                int sum = 0;
+                for (int dy = 0; dy < rowsY; dy++)
+                    for (int dx = 0; dx < columnsX; dx++)
+                        sum += src[((size_t)(2*y + dy) * srcWidth + 2*x + dx) * 4 + channel];
+                const int count = rowsY * columnsX;
+                dst[((size_t)y * dstWidth + x) * 4 + channel] = (unsigned char)((sum + count / 2) / count);
+            }
+        }
+    }
+}
+
+
+static const unsigned int checkpointMagic   = 0x5A445846; // "FXDZ".
+static const unsigned int checkpointVersion = 2;
+
+bool DeepZoomExporter::HasCheckpoint(const std::string& name)
+{
+    std::error_code error;
+    return std::filesystem::exists(name + ".checkpoint", error);
+}
+
+bool DeepZoomExporter::SaveCheckpoint(const std::string& name)
+{
+    // Export parameters.
+    std::vector<unsigned char> data;
+    PutValue(data, checkpointMagic);
+    PutValue(data, checkpointVersion);
+    PutValue(data, (int)fractalParams.fractal);
+    PutValue(data, (unsigned char)fractalParams.juliaSet);
+    PutValue(data, fractalParams.scale);
+    PutValue(data, fractalParams.offsetX);
+    PutValue(data, fractalParams.offsetY);
+    PutValue(data, fractalParams.complexCX);
+    PutValue(data, fractalParams.complexCY);
+    PutValue(data, fractalParams.viewWidth);
+    PutValue(data, fractalParams.viewHeight);
+    PutValue(data, fractalParams.maxIterations);
+    PutValue(data, (unsigned char)fractalParams.precision);
+    PutValue(data, colorParams.hueFg);
+    PutValue(data, colorParams.hueBg);
+    PutValue(data, (unsigned char)colorParams.colorWithZ);
+    PutValue(data, colorParams.maxIterations);
+    PutValue(data, width);
+    PutValue(data, height);
+    PutValue(data, tileSize);
+
+    // Progress of each level, with the rows of the tile rows that aren't written yet.
+    PutValue(data, (int)tileRowsRendered);
+    PutValue(data, GetLevelCount());
+    for (const Level& level : levels) {
+        PutValue(data, level.tileRowsWritten);
+        PutValue(data, level.pendingRows);
+        data.insert(data.end(), level.pending.begin(), level.pending.end());
+    }
+    PutValue(data, UpdateCrc32(0, data.data(), data.size()));
+
+    // Write to a temporary file and replace the previous checkpoint, so that a crash never leaves a broken one.
+    const std::string filename = name + ".checkpoint", tmpFilename = filename + ".tmp";
+    FILE* file = fopen(tmpFilename.c_str(), "wb");
+    if (!file) return false;
+    bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = fclose(file) == 0 && written;
+    std::error_code error;
+    if (written)
+        std::filesystem::rename(tmpFilename, filename, error);
+    return written && !error;
+}
+
+bool DeepZoomExporter::LoadCheckpoint(const std::string& name)
+{
+    // Read the whole checkpoint and check its integrity.
+    FILE* file = fopen((name + ".checkpoint").c_str(), "rb");
+    if (!file) return false;
+    std::vector<unsigned char> data;
+    unsigned char buffer[1 << 16];
+    size_t readSize;
+    while ((readSize = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data.insert(data.end(), buffer, buffer + readSize);
+    fclose(file);
+
+    unsigned int crc;
+    if (data.size() < sizeof(crc))
+        return false;
+    size_t crcPos = data.size() - sizeof(crc);
+    if (!GetValue(data, crcPos, crc) || crc != UpdateCrc32(0, data.data(), data.size() - sizeof(crc)))
+        return false;
+    data.resize(data.size() - sizeof(crc));
+
+    // Export parameters.
+    size_t pos = 0;
+    unsigned int  magic, version;
+    int           fractal;
+    unsigned char juliaSet, precision, colorWithZ;
+    FractalParams loadedFractalParams;
+    ColorParams   loadedColorParams;
+    int           loadedWidth, loadedHeight, loadedTileSize, loadedTileRowsRendered, levelCount;
+    bool valid = GetValue(data, pos, magic) && magic == checkpointMagic
+              && GetValue(data, pos, version) && version == checkpointVersion
+              && GetValue(data, pos, fractal) && fractal >= 0 && fractal < FRACTAL_COUNT
+              && GetValue(data, pos, juliaSet)
+              && GetValue(data, pos, loadedFractalParams.scale)
+              && GetValue(data, pos, loadedFractalParams.offsetX)
+              && GetValue(data, pos, loadedFractalParams.offsetY)
+              && GetValue(data, pos, loadedFractalParams.complexCX)
+              && GetValue(data, pos, loadedFractalParams.complexCY)
+              && GetValue(data, pos, loadedFractalParams.viewWidth)
+              && GetValue(data, pos, loadedFractalParams.viewHeight)
+              && GetValue(data, pos, loadedFractalParams.maxIterations)
+              && GetValue(data, pos, precision) && precision <= (unsigned char)FloatPrecision::Double
+              && GetValue(data, pos, loadedColorParams.hueFg)
+              && GetValue(data, pos, loadedColorParams.hueBg)
+              && GetValue(data, pos, colorWithZ)
+              && GetValue(data, pos, loadedColorParams.maxIterations)
+              && GetValue(data, pos, loadedWidth)    && loadedWidth    > 0
+              && GetValue(data, pos, loadedHeight)   && loadedHeight   > 0
+              && GetValue(data, pos, loadedTileSize) && loadedTileSize > 0 && loadedTileSize % 2 == 0
+              && GetValue(data, pos, loadedTileRowsRendered)
+              && GetValue(data, pos, levelCount);
+    if (!valid)
+        return false;
+
+    // Progress of each level.
+    std::vector<Level> loadedLevels = BuildLevels(loadedWidth, loadedHeight);
+    if (levelCount != (int)loadedLevels.size())
+        return false;
+    for (Level& level : loadedLevels)
+    {
+        if (!GetValue(data, pos, level.tileRowsWritten) || !GetValue(data, pos, level.pendingRows)
+         || level.pendingRows < 0 || level.pendingRows >= loadedTileSize)
+            return false;
+        const size_t pendingSize = (size_t)level.pendingRows * level.width * 4;
+        if (pos + pendingSize > data.size())
+            return false;
+        level.pending.assign(data.begin() + pos, data.begin() + pos + pendingSize);
+        pos += pendingSize;
+    }
+    if (pos != data.size())
+        return false;
+
+    fractalParams            = loadedFractalParams;
+    fractalParams.fractal    = (FractalTypes)fractal;
+    fractalParams.juliaSet   = juliaSet != 0;
+    fractalParams.precision  = (FloatPrecision)precision;
+    colorParams              = loadedColorParams;
+    colorParams.colorWithZ   = colorWithZ != 0;
+    width            = loadedWidth;
+    height           = loadedHeight;
+    tileSize         = loadedTileSize;
+    tileRowsRendered = loadedTileRowsRendered;
+    levels           = std::move(loadedLevels);
+    return true;
+}
+
+bool DeepZoomExporter::ResumeCheckpoint(const std::string& name)
+{
+    // The parameters go through the checkpoint unchanged, so they can be compared exactly.
+    DeepZoomExporter saved(fractalParams, colorParams, width, height, threadPool, tileSize);
+    if (!saved.LoadCheckpoint(name))
+        return false;
+    const FractalParams& a = fractalParams, & b = saved.fractalParams;
+    const bool sameParams = a.fractal == b.fractal && a.juliaSet == b.juliaSet && a.scale == b.scale
+                         && a.offsetX == b.offsetX && a.offsetY == b.offsetY && a.complexCX == b.complexCX && a.complexCY == b.complexCY
+                         && a.viewWidth == b.viewWidth && a.viewHeight == b.viewHeight && a.maxIterations == b.maxIterations && a.precision == b.precision
+                         && colorParams.hueFg == saved.colorParams.hueFg && colorParams.hueBg == saved.colorParams.hueBg
+                         && colorParams.colorWithZ == saved.colorParams.colorWithZ && colorParams.maxIterations == saved.colorParams.maxIterations
+                         && width == saved.width && height == saved.height && tileSize == saved.tileSize;
+    if (!sameParams)
+        return false;
+    tileRowsRendered = (int)saved.tileRowsRendered;
+    levels           = std::move(saved.levels);
+    return true;
+}
@@ -0,0 +1,177 @@
+#include "Deflate.h"
+#include <array>
+
+// Lengths and distances of the deflate format (RFC 1951).
+static const int lengthBase [29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0,  1,  1,  1,  1,  2,  2,  2,  2,  3,  3,  3,  3,  4,  4,  4,   4,   5,   5,   5,   5,   0 };
+static const int distBase   [30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const int distExtra  [30] = { 0, 0, 0, 0, 1, 1, 2,  2,  3,  3,  4,  4,  5,  5,   6,   6,   7,   7,   8,   8,    9,    9,   10,   10,   11,   11,   12,    12,    13,    13 };
+
+// Writes bits in the order expected by deflate (least significant bit first).
+struct BitWriter
+{
+    std::vector<unsigned char>& out;
+    unsigned int bits     = 0;
+    int          bitCount = 0;
+
+    void Put(const unsigned int& value, const int& count)
+    {
+        bits |= value << bitCount;
+        bitCount += count;
+        while (bitCount >= 8) {
+            out.push_back((unsigned char)(bits & 0xFF));
+            bits >>= 8;
+            bitCount -= 8;
+        }
+    }
+    void Align()
+    {
+        if (bitCount > 0)
+            Put(0, 8 - bitCount);
+    }
+};
+
+// Huffman codes are stored most significant bit first, so they need to be reversed before being written.
+static unsigned int ReverseBits(unsigned int code, const int& length)
+{
+    unsigned int reversed = 0;
+    for (int i = 0; i < length; i++, code >>= 1)
+        reversed = (reversed << 1) | (code & 1);
+    return reversed;
+}
+
+// Writes a literal/length symbol using the fixed huffman table.
+static void PutSymbol(BitWriter& writer, const int& symbol)
+{
+    if      (symbol < 144) writer.Put(ReverseBits(0x30  + symbol,       8), 8);
+    else if (symbol < 256) writer.Put(ReverseBits(0x190 + symbol - 144, 9), 9);
+    else if (symbol < 280) writer.Put(ReverseBits(symbol - 256,         7), 7);
+    else                   writer.Put(ReverseBits(0xC0  + symbol - 280, 8), 8);
+}
+
+// Writes a back-reference of the given length and distance.
+static void PutMatch(BitWriter& writer, const int& length, const int& distance)
+{
+    int lengthCode = 28;
+    while (lengthBase[lengthCode] > length) lengthCode--;
+    PutSymbol(writer, 257 + lengthCode);
+    writer.Put(length - lengthBase[lengthCode], lengthExtra[lengthCode]);
+
+    int distCode = 29;
+    while (distBase[distCode] > distance) distCode--;
+    writer.Put(ReverseBits(distCode, 5), 5);
+    writer.Put(distance - distBase[distCode], distExtra[distCode]);
+}
+
+void DeflateBlock(const unsigned char* data, const int& size, std::vector<unsigned char>& out)
+{
+    const int hashBits = 15, windowSize = 32768, maxChain = 16, minMatch = 3, maxMatch = 258;
+    std::vector<int> head(1 << hashBits, -1), prev(windowSize, -1);
+    auto hash   = [&](const int& pos) { return ((data[pos] << 10) ^ (data[pos+1] << 5) ^ data[pos+2]) & ((1 << hashBits) - 1); };
+    auto insert = [&](const int& pos) {
+        if (pos + minMatch > size) return;
+        int h = hash(pos);
+        prev[pos & (windowSize - 1)] = head[h];
+        head[h] = pos;
+    };
+
+    BitWriter writer { out };
+    writer.Put(0, 1); // Not the last block.
+    writer.Put(1, 2); // Fixed huffman codes.
+
+    int i = 0;
+    while (i < size)
+    {
+        // Find the longest match in the hash chain of the current position.
+        int bestLength = 0, bestDistance = 0;
+        if (i + minMatch <= size)
+        {
+            int maxLength = size - i < maxMatch ? size - i : maxMatch;
+            int candidate = head[hash(i)];
+            for (int chain = 0; chain < maxChain && candidate >= 0 && i - candidate <= windowSize; chain++)
+            {
+                if (data[candidate + bestLength] == data[i + bestLength])
+                {
+                    int length = 0;
+                    while (length < maxLength && data[candidate + length] == data[i + length]) length++;
+                    if (length > bestLength) {
+                        bestLength   = length;
+                        bestDistance = i - candidate;
+                        if (length == maxLength) break;
+                    }
+                }
+                int next = prev[candidate & (windowSize - 1)];
+                if (next >= candidate) break;
+                candidate = next;
+            }
+        }
+
+        // Write either the match or a literal.
+        if (bestLength >= minMatch) {
+            PutMatch(writer, bestLength, bestDistance);
+            for (int end = i + bestLength; i < end; i++)
+                insert(i);
+        }
+        else {
+            PutSymbol(writer, data[i]);
+            insert(i);
+            i++;
+        }
+    }
+    PutSymbol(writer, 256);
+
+    // Full flush: an empty stored block brings the stream back to a byte boundary.
+    writer.Put(0, 1);
+    writer.Put(0, 2);
+    writer.Align();
+    const unsigned char emptyStoredBlock[4] = { 0x00, 0x00, 0xFF, 0xFF };
+    out.insert(out.end(), emptyStoredBlock, emptyStoredBlock + 4);
+}
+
+unsigned int UpdateAdler32(unsigned int adler, const unsigned char* data, size_t size)
+{
+    unsigned int s1 = adler & 0xFFFF, s2 = adler >> 16;
+    while (size > 0)
+    {
+        size_t blockSize = size < 5552 ? size : 5552;
+        for (size_t i = 0; i < blockSize; i++) {
+            s1 += data[i];
+            s2 += s1;
+        }
+        s1 %= 65521; s2 %= 65521;
+        data += blockSize;
+        size -= blockSize;
+    }
+    return (s2 << 16) | s1;
+}
+
+unsigned int UpdateCrc32(unsigned int crc, const unsigned char* data, const size_t& size)
+{
+    // Built once by the first caller, callers on other threads wait for it.
+    static const std::array<unsigned int, 256> table = []() {
+        std::array<unsigned int, 256> crcs;
+        for (unsigned int n = 0; n < 256; n++) {
+            unsigned int c = n;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crcs[n] = c;
+        }
+        return crcs;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void ZlibCompress(const unsigned char* data, const int& size, std::vector<unsigned char>& out)
+{
+    out.push_back(0x78);
+    out.push_back(0x01);
+    DeflateBlock(data, size, out);
+
+    // Empty final block and adler checksum.
+    const unsigned int adler = UpdateAdler32(1, data, size);
+    const unsigned char end[9] = { 0x01, 0x00, 0x00, 0xFF, 0xFF, (unsigned char)(adler >> 24), (unsigned char)(adler >> 16), (unsigned char)(adler >> 8), (unsigned char)adler };
+    out.insert(out.end(), end, end + 9);
+}
@@ -0,0 +1,197 @@
+#include "DiskSampleCache.h"
+#include "BinaryIO.h"
+#include "Deflate.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+// Entries are stored in the native byte order, the cache isn't meant to be moved to another machine.
+static const unsigned int cacheMagic   = 0x43535846; // "FXSC".
+static const unsigned int cacheVersion = 1;
+static const char*        extension    = ".samples";
+
+
+DiskSampleCache::DiskSampleCache(const std::string& _directory, const size_t& _maxBytes)
+    : directory(_directory), maxBytes(_maxBytes)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error || directory.empty())
+        return;
+    open = true;
+
+    // Index the existing files from the most recently used to the least recently used. Temporary files left by
+    // crashed writes are deleted, unless they are recent enough to belong to a write in progress.
+    struct FoundFile
+    {
+        std::string filename;
+        size_t      byteSize;
+        std::filesystem::file_time_type lastUse;
+    };
+    std::vector<FoundFile> foundFiles;
+    const auto staleTime = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+    for (auto it = std::filesystem::directory_iterator(directory, error); !error && it != std::filesystem::directory_iterator(); it.increment(error))
+    {
+        std::error_code fileError;
+        const std::filesystem::path path = it->path();
+        const auto lastUse  = it->last_write_time(fileError);
+        const auto byteSize = it->file_size(fileError);
+        if (fileError || !it->is_regular_file(fileError))
+            continue;
+        if (path.extension() == extension)
+            foundFiles.push_back({ path.filename().string(), (size_t)byteSize, lastUse });
+        else if (path.extension() == ".tmp" && lastUse < staleTime)
+            std::filesystem::remove(path, fileError);
+    }
+    std::sort(foundFiles.begin(), foundFiles.end(), [](const FoundFile& a, const FoundFile& b) { return a.lastUse > b.lastUse; });
+
+    for (const FoundFile& file : foundFiles) {
+        entries.push_back({ file.filename, file.byteSize });
+        index[file.filename] = std::prev(entries.end());
+        usedBytes += file.byteSize;
+    }
+    Trim();
+}
+
+std::string DiskSampleCache::GetFilename(const std::string& key)
+{
+    char filename[32];
+    snprintf(filename, sizeof(filename), "%016llx%s", SampleCache::HashKey(key), extension);
+    return filename;
+}
+
+void DiskSampleCache::Touch(const std::string& filename, const size_t& byteSize)
+{
+    // Move the entry to the front of the list, adding it if needed. Must be called with the mutex locked.
+    auto found = index.find(filename);
+    if (found != index.end()) {
+        usedBytes -= found->second->byteSize;
+        entries.erase(found->second);
+    }
+    entries.push_front({ filename, byteSize });
+    index[filename] = entries.begin();
+    usedBytes += byteSize;
+}
+
+void DiskSampleCache::Trim()
+{
+    // Delete the least recently used files until the cache fits in its budget. Must be called with the mutex locked.
+    while (!entries.empty() && usedBytes > maxBytes)
+    {
+        std::error_code error;
+        std::filesystem::remove(directory + "/" + entries.back().filename, error);
+        usedBytes -= entries.back().byteSize;
+        index.erase(entries.back().filename);
+        entries.pop_back();
+    }
+}
+
+bool DiskSampleCache::Contains(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.count(GetFilename(key)) > 0;
+}
+
+SampleCache::Samples DiskSampleCache::Find(const std::string& key)
+{
+    if (!open)
+        return nullptr;
+
+    // Read the whole file and check its integrity.
+    const std::string filename = GetFilename(key), path = directory + "/" + filename;
+    std::vector<unsigned char> data;
+    if (FILE* file = fopen(path.c_str(), "rb"))
+    {
+        unsigned char buffer[1 << 16];
+        size_t readSize;
+        while ((readSize = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            data.insert(data.end(), buffer, buffer + readSize);
+        fclose(file);
+    }
+
+    unsigned int crc, magic, version, keySize, sampleCount;
+    size_t crcPos = data.size() - sizeof(crc), pos = 0;
+    bool valid = data.size() >= sizeof(crc)
+              && GetValue(data, crcPos, crc) && crc == UpdateCrc32(0, data.data(), data.size() - sizeof(crc))
+              && GetValue(data, pos, magic) && magic == cacheMagic
+              && GetValue(data, pos, version) && version == cacheVersion
+              && GetValue(data, pos, keySize) && pos + keySize <= data.size()
+              && key.compare(0, std::string::npos, (const char*)data.data() + pos, keySize) == 0;
+    pos += valid ? keySize : 0;
+    valid = valid && GetValue(data, pos, sampleCount) && pos + (size_t)sampleCount * sizeof(FractalSample) + sizeof(crc) == data.size();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!valid) {
+        missCount++;
+        return nullptr;
+    }
+    hitCount++;
+    Touch(filename, data.size());
+
+    // Mark the file as recently used for the next sessions too.
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+    auto samples = std::make_shared<std::vector<FractalSample>>(sampleCount);
+    memcpy(samples->data(), data.data() + pos, (size_t)sampleCount * sizeof(FractalSample));
+    return samples;
+}
+
+void DiskSampleCache::Insert(const std::string& key, const SampleCache::Samples& samples)
+{
+    if (!open || !samples)
+        return;
+
+    std::vector<unsigned char> data;
+    PutValue(data, cacheMagic);
+    PutValue(data, cacheVersion);
+    PutValue(data, (unsigned int)key.size());
+    data.insert(data.end(), key.begin(), key.end());
+    PutValue(data, (unsigned int)samples->size());
+    const unsigned char* sampleBytes = (const unsigned char*)samples->data();
+    data.insert(data.end(), sampleBytes, sampleBytes + samples->size() * sizeof(FractalSample));
+    PutValue(data, UpdateCrc32(0, data.data(), data.size()));
+    if (data.size() > maxBytes)
+        return;
+
+    // Write to a temporary file with a unique name, since other threads or programs may be writing the same entry,
+    // then move it in place.
+    static std::atomic<unsigned long long> tmpCounter{ std::random_device{}() };
+    const std::string filename = GetFilename(key), path = directory + "/" + filename;
+    const std::string tmpPath  = path + "." + std::to_string(tmpCounter++) + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (!file) return;
+    bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = fclose(file) == 0 && written;
+    std::error_code error;
+    if (written)
+        std::filesystem::rename(tmpPath, path, error);
+    if (!written || error) {
+        std::filesystem::remove(tmpPath, error);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Touch(filename, data.size());
+    Trim();
+}
+
+std::string DiskSampleCache::GetDefaultDirectory()
+{
+    #if defined(_WIN32)
+        const char* localAppData = getenv("LOCALAPPDATA");
+        return localAppData ? std::string(localAppData) + "\\FractalExplorer\\SampleCache" : "SampleCache";
+    #else
+        const char* cacheHome = getenv("XDG_CACHE_HOME");
+        const char* home      = getenv("HOME");
+        if (cacheHome && cacheHome[0])
+            return std::string(cacheHome) + "/fractal-explorer/samples";
+        return home ? std::string(home) + "/.cache/fractal-explorer/samples" : "SampleCache";
+    #endif
+}
@@ -0,0 +1,178 @@
+#include "ExrWriter.h"
+#include "Deflate.h"
+#include <algorithm>
+#include <cstring>
+
+static void PutInt(std::vector<unsigned char>& out, const unsigned long long& value, const int& byteCount)
+{
+    // OpenEXR is little endian.
+    for (int i = 0; i < byteCount; i++)
+        out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+// Seeks with 64 bit offsets, since fseek takes a long which is 32 bits on Windows.
+static bool SeekTo(FILE* file, const unsigned long long& position)
+{
+    #if defined(_WIN32)
+        return _fseeki64(file, (long long)position, SEEK_SET) == 0;
+    #else
+        return fseeko(file, (off_t)position, SEEK_SET) == 0;
+    #endif
+}
+
+static void PutAttribute(std::vector<unsigned char>& out, const char* name, const char* type, const std::vector<unsigned char>& value)
+{
+    out.insert(out.end(), name, name + strlen(name) + 1);
+    out.insert(out.end(), type, type + strlen(type) + 1);
+    PutInt(out, value.size(), 4);
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+
+ExrWriter::ExrWriter(const int& _width, const int& _height, const std::vector<std::string>& _channelNames, const ExrCompression& _compression)
+    : width(_width), height(_height), compression(_compression)
+{
+    // Channels have to be stored in alphabetical order.
+    for (int i = 0; i < (int)_channelNames.size(); i++)
+        channelOrder.push_back(i);
+    std::sort(channelOrder.begin(), channelOrder.end(), [&](const int& a, const int& b) { return _channelNames[a] < _channelNames[b]; });
+    for (const int& i : channelOrder)
+        channelNames.push_back(_channelNames[i]);
+}
+
+ExrWriter::~ExrWriter()
+{
+    if (file) fclose(file);
+}
+
+bool ExrWriter::Open(const char* filename)
+{
+    file = fopen(filename, "wb");
+    if (!file) return false;
+    WriteHeader();
+    return true;
+}
+
+void ExrWriter::OpenInMemory()
+{
+    inMemory = true;
+    WriteHeader();
+}
+
+void ExrWriter::WriteHeader()
+{
+    std::vector<unsigned char> header = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 }; // Magic number and version 2, single part scanline.
+
+    // Channel list: 32 bit floats, not sampled.
+    std::vector<unsigned char> channels;
+    for (const std::string& name : channelNames)
+    {
+        channels.insert(channels.end(), name.c_str(), name.c_str() + name.size() + 1);
+        PutInt(channels, 2, 4);          // Float pixels.
+        PutInt(channels, 0, 4);          // Not perceptually linear and reserved bytes.
+        PutInt(channels, 1, 4);          // X sampling.
+        PutInt(channels, 1, 4);          // Y sampling.
+    }
+    channels.push_back(0);
+    PutAttribute(header, "channels", "chlist", channels);
+    PutAttribute(header, "compression", "compression", { (unsigned char)compression });
+
+    std::vector<unsigned char> window;
+    PutInt(window, 0, 4); PutInt(window, 0, 4); PutInt(window, width - 1, 4); PutInt(window, height - 1, 4);
+    PutAttribute(header, "dataWindow",    "box2i", window);
+    PutAttribute(header, "displayWindow", "box2i", window);
+    PutAttribute(header, "lineOrder",     "lineOrder", { 0 }); // Increasing Y.
+
+    const float one = 1.f;
+    std::vector<unsigned char> oneBytes((const unsigned char*)&one, (const unsigned char*)&one + 4);
+    PutAttribute(header, "pixelAspectRatio",   "float", oneBytes);
+    PutAttribute(header, "screenWindowCenter", "v2f",   std::vector<unsigned char>(8, 0));
+    PutAttribute(header, "screenWindowWidth",  "float", oneBytes);
+    header.push_back(0);
+
+    // Reserve the offset table, it is filled in once all blocks are written.
+    offsetTablePos = header.size();
+    header.resize(header.size() + (size_t)GetBlockCount() * 8, 0);
+    Append(header.data(), header.size());
+}
+
+void ExrWriter::EncodeBlock(const int& block, const float* pixels, std::vector<unsigned char>& encoded)
+{
+    // Scanlines are stored one after the other, each with all the values of one channel followed by the next channel.
+    const int    firstLine = block * GetLinesPerBlock();
+    const int    lineCount = std::min(GetLinesPerBlock(), height - firstLine);
+    const size_t pixelSize = channelNames.size();
+    std::vector<unsigned char> raw;
+    raw.reserve((size_t)lineCount * width * pixelSize * 4);
+    for (int line = 0; line < lineCount; line++)
+    {
+        for (const int& channel : channelOrder)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                const float value = pixels[((size_t)line * width + x) * pixelSize + channel];
+                const unsigned char* bytes = (const unsigned char*)&value;
+                raw.insert(raw.end(), bytes, bytes + 4);
+            }
+        }
+    }
+
+    std::vector<unsigned char> compressed;
+    if (compression == ExrCompression::Zip)
+    {
+        // Split the even and odd bytes, then store the differences between consecutive bytes before compressing.
+        std::vector<unsigned char> reordered(raw.size());
+        const size_t half = (raw.size() + 1) / 2;
+        for (size_t i = 0; i < raw.size(); i++)
+            reordered[i % 2 == 0 ? i / 2 : half + i / 2] = raw[i];
+        for (size_t i = reordered.size() - 1; i > 0; i--)
+            reordered[i] = (unsigned char)(reordered[i] - reordered[i-1] + 128);
+        ZlibCompress(reordered.data(), (int)reordered.size(), compressed);
+
+        // Blocks that don't get smaller are stored uncompressed.
+        if (compressed.size() >= raw.size())
+            compressed.clear();
+    }
+    const std::vector<unsigned char>& data = compressed.empty() ? raw : compressed;
+
+    encoded.clear();
+    PutInt(encoded, firstLine, 4);
+    PutInt(encoded, data.size(), 4);
+    encoded.insert(encoded.end(), data.begin(), data.end());
+}
+
+void ExrWriter::WriteBlock(const std::vector<unsigned char>& encoded)
+{
+    blockOffsets.push_back(fileSize);
+    Append(encoded.data(), encoded.size());
+}
+
+bool ExrWriter::Close()
+{
+    // Fill in the offset table.
+    std::vector<unsigned char> offsetTable;
+    for (const unsigned long long& offset : blockOffsets)
+        PutInt(offsetTable, offset, 8);
+
+    bool success = (int)blockOffsets.size() == GetBlockCount();
+    if (inMemory) {
+        memcpy(output.data() + offsetTablePos, offsetTable.data(), offsetTable.size());
+    }
+    else if (file) {
+        success = SeekTo(file, offsetTablePos) && success;
+        fwrite(offsetTable.data(), 1, offsetTable.size(), file);
+        success = !ferror(file) && success;
+        fclose(file);
+        file = nullptr;
+    }
+    return success;
+}
+
+void ExrWriter::Append(const unsigned char* data, const size_t& size)
+{
+    if (inMemory)
+        output.insert(output.end(), data, data + size);
+    else if (file)
+        fwrite(data, 1, size, file);
+    fileSize += size;
+}
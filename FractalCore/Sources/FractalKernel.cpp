@@ -0,0 +1,173 @@
+#include "FractalKernel.h"
+#include <algorithm>
+#include <cmath>
+
+// Complex number operations, ported from the fractal shader so that both give the same images.
+template<typename T> struct Complex
+{
+    T x, y;
+};
+template<typename T> static Complex<T> operator+(const Complex<T>& a, const Complex<T>& b) { return { a.x + b.x, a.y + b.y }; }
+template<typename T> static Complex<T> operator-(const Complex<T>& a, const Complex<T>& b) { return { a.x - b.x, a.y - b.y }; }
+template<typename T> static Complex<T> operator*(const Complex<T>& a, const T& b)          { return { a.x * b,   a.y * b   }; }
+template<typename T> static Complex<T> operator/(const Complex<T>& a, const T& b)          { return { a.x / b,   a.y / b   }; }
+
+template<typename T> static Complex<T> ComplexProd  (const Complex<T>& c1, const Complex<T>& c2) { return { c1.x*c2.x - c1.y*c2.y, c1.x*c2.y + c1.y*c2.x }; }
+template<typename T> static Complex<T> ComplexSquare(const Complex<T>& c)                        { return { c.x*c.x - c.y*c.y, (T)2 * c.x * c.y }; }
+template<typename T> static T          ComplexAbs   (const Complex<T>& c)                        { return std::sqrt(c.x*c.x + c.y*c.y); }
+template<typename T> static T          ComplexArg   (const Complex<T>& c)                        { return std::atan(c.y / c.x); }
+template<typename T> static Complex<T> ComplexExp   (const Complex<T>& c)                        { return Complex<T>{ std::cos(c.y), std::sin(c.y) } * std::exp(c.x); }
+template<typename T> static Complex<T> ComplexLog   (const Complex<T>& c)                        { return { std::log(ComplexAbs(c)), ComplexArg(c) }; }
+template<typename T> static Complex<T> ComplexPowC  (const Complex<T>& c, const Complex<T>& n)   { return ComplexExp(ComplexProd(ComplexLog(c), n)); }
+template<typename T> static Complex<T> ComplexDiv   (const Complex<T>& c1, const Complex<T>& c2)
+{
+    T c2x2 = c2.x * c2.x, c2y2 = c2.y * c2.y;
+    return { (c1.x*c2.x + c1.y*c2.y) / (c2x2 + c2y2), (c1.y*c2.x - c1.x*c2.y) / (c2x2 + c2y2) };
+}
+
+// Position of the point at the given position of the view (in view pixels), and its initial z and c, with numbers of type T.
+template<typename T> static void InitPoint(const FractalParams& params, const double& viewX, const double& viewY, Complex<T>& z, Complex<T>& c)
+{
+    using C = Complex<T>;
+    const T zoom  = (T)std::pow(2.0, params.scale);
+    const C pos   = { (T)viewX, (T)viewY };
+    const C point = (pos - C{ (T)params.viewWidth / 2, (T)params.viewHeight / 2 }) / ((T)0.5 * zoom * (T)params.viewHeight)
+                  + C{ (T)params.offsetX, (T)params.offsetY } / zoom;
+
+    // Initialize z and c for the fractal or its julia sets.
+    if (!params.juliaSet) {
+        z = { 0, 0 };
+        c = point + C{ (T)-0.125, 0 };
+    }
+    else {
+        z = point;
+        c = { (T)params.complexCX, (T)params.complexCY };
+    }
+}
+
+// Iterates z from iteration i until it escapes or iteration endIteration is reached, and returns the iteration it
+// stopped at. z^2 only depends on z, so z and i are all it takes to resume the iteration.
+template<typename T> static int IterateFrom(const FractalParams& params, Complex<T>& z, const Complex<T>& c, int i, const int& endIteration)
+{
+    using C = Complex<T>;
+    const C complexI    = { 0, 1 };
+    const T escapeRadSq = 4;
+
+    C z2 = ComplexSquare(z);
+
+    // Iterate the fractal equation. The shader's escape test (on z^2) is kept as is to get the same images.
+    for (; i < endIteration && z2.x + z2.y < escapeRadSq; i++)
+    {
+        C cIt = c + C{ (T)0.125, 0 };
+        switch (params.fractal)
+        {
+            case FractalTypes::MandelbrotSet:
+                z = z2 + cIt - C{ (T)0.25, 0 };
+                break;
+            case FractalTypes::BurningShip:
+                z = ComplexSquare(C{ std::fabs(z.x), std::fabs(z.y) }) + cIt - C{ (T)0.25, 0 };
+                break;
+            case FractalTypes::CrescentMoon:
+                z = ComplexDiv(z + C{ 1, 0 }, ComplexExp(z) + cIt / (T)0.47);
+                break;
+            case FractalTypes::NorthStar:
+            {
+                C zPlusC = z + ComplexProd((cIt + C{ 0, (T)-0.1 }) / (T)0.65, C{ 0, -1 });
+                z = ComplexDiv(C{ 1, 0 }, ComplexSquare(ComplexSquare(zPlusC)));
+                break;
+            }
+            case FractalTypes::LoversFractal:
+            {
+                cIt = C{ std::fabs(cIt.x), cIt.y } * (T)0.75 + C{ (T)0.125, (T)0.155 };
+                z = ComplexDiv(z2, C{ 0, 0 } - complexI + ComplexPowC(cIt, z)) + cIt;
+                break;
+            }
+            default:
+                break;
+        }
+        z2 = ComplexSquare(z);
+    }
+    return i;
+}
+
+// Sample of a point whose iteration stopped at iteration i.
+template<typename T> static FractalSample MakeSample(const FractalParams& params, const Complex<T>& z, const int& i)
+{
+    // Smooth iteration count: remove the fractional part of the escape speed (defined for escaping points only).
+    FractalSample sample = { (float)i, (float)i, (float)z.x, (float)z.y };
+    double zAbs = ComplexAbs(Complex<double>{ (double)z.x, (double)z.y });
+    if (i < params.maxIterations && zAbs > 1.0 && std::isfinite(zAbs))
+        sample.smoothIterations = (float)(i + 1 - log2(log(zAbs)));
+    return sample;
+}
+
+// Iterates the point at the given position of the view (in view pixels) with numbers of type T.
+template<typename T> static FractalSample IteratePoint(const FractalParams& params, const double& viewX, const double& viewY)
+{
+    Complex<T> z, c;
+    InitPoint(params, viewX, viewY, z, c);
+    const int i = IterateFrom(params, z, c, 0, params.maxIterations);
+    return MakeSample(params, z, i);
+}
+
+// Same as IteratePoint, for at most the given number of iterations from the state of the point.
+template<typename T> static bool ContinuePoint(const FractalParams& params, const double& viewX, const double& viewY, PointIteration& state, const int& maxSteps, FractalSample& out)
+{
+    Complex<T> z, c;
+    InitPoint(params, viewX, viewY, z, c);
+    if (state.iterations > 0)
+        z = { (T)state.zRe, (T)state.zIm };
+
+    const int endIteration = state.iterations + std::min(maxSteps, params.maxIterations - state.iterations);
+    const int i = IterateFrom(params, z, c, state.iterations, endIteration);
+    state = { (double)z.x, (double)z.y, i };
+    if (i == endIteration && i < params.maxIterations)
+        return false;
+    out = MakeSample(params, z, i);
+    return true;
+}
+
+
+FractalKernel::FractalKernel(const FractalParams& _params, const int& _width, const int& _height)
+    : params(_params), width(_width), height(_height)
+{
+}
+
+FractalSample FractalKernel::ComputeSample(const double& x, const double& y)
+{
+    // Same coordinates as the shader's fragTexCoord * screenSize, the image being stretched over the view.
+    const double viewX = x / width * params.viewWidth, viewY = y / height * params.viewHeight;
+    if (params.precision == FloatPrecision::Single)
+        return IteratePoint<float>(params, viewX, viewY);
+    return IteratePoint<double>(params, viewX, viewY);
+}
+
+bool FractalKernel::ContinueSample(const double& x, const double& y, PointIteration& state, const int& maxSteps, FractalSample& out)
+{
+    const double viewX = x / width * params.viewWidth, viewY = y / height * params.viewHeight;
+    if (params.precision == FloatPrecision::Single)
+        return ContinuePoint<float>(params, viewX, viewY, state, maxSteps, out);
+    return ContinuePoint<double>(params, viewX, viewY, state, maxSteps, out);
+}
+
+FractalSample FractalKernel::ComputePixel(const int& x, const int& y)
+{
+    return ComputeSample(x + 0.5, y + 0.5);
+}
+
+int FractalKernel::ComputeRows(const int& firstRow, const int& rowCount, FractalSample* out, const CancellationToken& cancel)
+{
+    return ComputeRegion(0, firstRow, width, rowCount, out, cancel);
+}
+
+int FractalKernel::ComputeRegion(const int& x, const int& y, const int& regionWidth, const int& regionHeight, FractalSample* out, const CancellationToken& cancel)
+{
+    for (int row = 0; row < regionHeight; row++)
+    {
+        if (cancel.IsCancelled())
+            return row;
+        for (int pixelX = x; pixelX < x + regionWidth; pixelX++)
+            *out++ = ComputePixel(pixelX, y + row);
+    }
+    return regionHeight;
+}
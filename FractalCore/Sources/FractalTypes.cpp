@@ -0,0 +1,39 @@
+#include "FractalTypes.h"
+#include <cctype>
+#include <cstdlib>
+#include <string>
+
+const char* FractalNames::names[FRACTAL_COUNT] = { "Mandelbrot Set", "Burning Ship", "Crescent Moon", "North Star", "Lovers' Fractal" };
+
+FractalTypes operator++(FractalTypes& type)
+{
+    type = static_cast<FractalTypes>(((int)type + 1) % FRACTAL_COUNT);
+    return type;
+}
+FractalTypes operator--(FractalTypes& type)
+{
+    type = static_cast<FractalTypes>((int)type - 1 >= 0 ? (int)type - 1 : FRACTAL_COUNT - 1);
+    return type;
+}
+
+// Returns the lowercase letters and digits of the given string, to compare names loosely.
+static std::string SimplifyName(const char* name)
+{
+    std::string simplified;
+    for (; *name; name++)
+        if (isalnum((unsigned char)*name))
+            simplified += (char)tolower((unsigned char)*name);
+    return simplified;
+}
+
+bool FractalNames::Parse(const char* name, FractalTypes& type)
+{
+    const std::string simplified = SimplifyName(name);
+    for (int i = 0; i < FRACTAL_COUNT; i++) {
+        if (simplified == SimplifyName(names[i]) || simplified == std::to_string(i)) {
+            type = (FractalTypes)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,123 @@
+#include "MemoryBudget.h"
+#include <cstdio>
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <psapi.h>
+    #pragma comment(lib, "psapi.lib")
+#elif defined(__linux__)
+    #include <unistd.h>
+#endif
+
+int MemoryBudget::Register(const std::string& name, const Reclaimer& reclaimer)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    accounts.push_back({ name, 0, 0, reclaimer });
+    return (int)accounts.size() - 1;
+}
+
+void MemoryBudget::Unregister(const int& account)
+{
+    // Wait for a reclaim that could be calling the reclaimer.
+    std::lock_guard<std::mutex> reclaimLock(reclaimMutex);
+    std::lock_guard<std::mutex> lock(mutex);
+    usedBytes -= accounts[account].bytes;
+    accounts[account].bytes      = 0;
+    accounts[account].reclaimer  = nullptr;
+    accounts[account].registered = false;
+}
+
+void MemoryBudget::Charge(const int& account, const size_t& bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Account& charged = accounts[account];
+        charged.bytes    += bytes;
+        charged.peakBytes = charged.bytes > charged.peakBytes ? charged.bytes : charged.peakBytes;
+        usedBytes        += bytes;
+        peakBytes         = usedBytes > peakBytes ? usedBytes : peakBytes;
+        if (ceiling == 0 || usedBytes <= ceiling)
+            return;
+    }
+    MakeRoom(0);
+}
+
+void MemoryBudget::Credit(const int& account, const size_t& bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Account& credited = accounts[account];
+    const size_t creditedBytes = bytes < credited.bytes ? bytes : credited.bytes;
+    credited.bytes -= creditedBytes;
+    usedBytes      -= creditedBytes;
+}
+
+size_t MemoryBudget::MakeRoom(const size_t& wanted)
+{
+    std::lock_guard<std::mutex> reclaimLock(reclaimMutex);
+    for (size_t account = 0; ; account++)
+    {
+        Reclaimer reclaimer;
+        size_t    overBytes, usedBefore;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ceiling == 0 || usedBytes + wanted <= ceiling)
+                return wanted;
+            if (account >= accounts.size())
+                return usedBytes < ceiling ? ceiling - usedBytes : 0;
+            reclaimer  = accounts[account].reclaimer;
+            overBytes  = usedBytes + wanted - ceiling;
+            usedBefore = usedBytes;
+        }
+        if (!reclaimer)
+            continue;
+
+        reclaimer(overBytes);
+        std::lock_guard<std::mutex> lock(mutex);
+        reclaimedBytes += usedBefore > usedBytes ? usedBefore - usedBytes : 0;
+    }
+}
+
+void MemoryBudget::SetCeiling(const size_t& _ceiling)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ceiling = _ceiling;
+    }
+    MakeRoom(0);
+}
+
+size_t MemoryBudget::GetCeiling       () { std::lock_guard<std::mutex> lock(mutex); return ceiling;        }
+size_t MemoryBudget::GetUsedBytes     () { std::lock_guard<std::mutex> lock(mutex); return usedBytes;      }
+size_t MemoryBudget::GetPeakBytes     () { std::lock_guard<std::mutex> lock(mutex); return peakBytes;      }
+size_t MemoryBudget::GetReclaimedBytes() { std::lock_guard<std::mutex> lock(mutex); return reclaimedBytes; }
+
+std::string MemoryBudget::GetReport()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string report;
+    for (const Account& account : accounts)
+    {
+        if (!account.registered) continue;
+        char line[256];
+        snprintf(line, sizeof(line), "%-20s %9.1f MB (peak %.1f MB)\n", account.name.c_str(), account.bytes / 1048576.0, account.peakBytes / 1048576.0);
+        report += line;
+    }
+    return report;
+}
+
+size_t MemoryBudget::GetResidentBytes()
+{
+    #if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+    #elif defined(__linux__)
+        // The second field of statm is the number of resident pages.
+        size_t totalPages = 0, residentPages = 0;
+        FILE* statm = fopen("/proc/self/statm", "r");
+        if (!statm) return 0;
+        const bool valid = fscanf(statm, "%zu %zu", &totalPages, &residentPages) == 2;
+        fclose(statm);
+        return valid ? residentPages * (size_t)sysconf(_SC_PAGESIZE) : 0;
+    #else
+        return 0;
+    #endif
+}
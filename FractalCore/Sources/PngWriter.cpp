@@ -0,0 +1,149 @@
+#include "PngWriter.h"
+#include "Deflate.h"
+#include <cstring>
+#include <cstdlib>
+
+static void PutBigEndian(std::vector<unsigned char>& out, const unsigned int& value)
+{
+    out.push_back((unsigned char)(value >> 24));
+    out.push_back((unsigned char)(value >> 16));
+    out.push_back((unsigned char)(value >> 8 ));
+    out.push_back((unsigned char)(value      ));
+}
+
+
+PngWriter::PngWriter(const int& _width, const int& _height)
+    : width(_width), height(_height)
+{
+    prevRow.resize((size_t)width * 4, 0);
+}
+
+PngWriter::~PngWriter()
+{
+    if (file) fclose(file);
+}
+
+bool PngWriter::Open(const char* filename)
+{
+    file = fopen(filename, "wb");
+    if (!file) return false;
+
+    OpenInMemory();
+    inMemory = false;
+    FlushOutput();
+    return true;
+}
+
+void PngWriter::OpenInMemory()
+{
+    inMemory = true;
+
+    // Png signature and header.
+    const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    output.insert(output.end(), signature, signature + 8);
+
+    std::vector<unsigned char> header;
+    PutBigEndian(header, width);
+    PutBigEndian(header, height);
+    header.push_back(8); // Bit depth.
+    header.push_back(6); // RGBA.
+    header.push_back(0); // Deflate.
+    header.push_back(0); // Adaptive filtering.
+    header.push_back(0); // No interlacing.
+    WriteChunk("IHDR", header.data(), header.size());
+}
+
+void PngWriter::FilterRow(const unsigned char* row, unsigned char* dst)
+{
+    // Pick the filter that gives the smallest sum of absolute values, like most encoders do.
+    const int rowSize = width * 4;
+    auto filterByte = [&](const int& filter, const int& i) -> unsigned char
+    {
+        int a = i >= 4 ? row[i-4] : 0, b = prevRow[i], c = i >= 4 ? prevRow[i-4] : 0;
+        switch (filter)
+        {
+            case 1:  return (unsigned char)(row[i] - a);
+            case 2:  return (unsigned char)(row[i] - b);
+            case 3:  return (unsigned char)(row[i] - ((a + b) >> 1));
+            case 4:
+            {
+                int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+                return (unsigned char)(row[i] - (pa <= pb && pa <= pc ? a : pb <= pc ? b : c));
+            }
+            default: return row[i];
+        }
+    };
+
+    long long sums[5] = { 0 };
+    for (int i = 0; i < rowSize; i++)
+        for (int filter = 0; filter < 5; filter++)
+            sums[filter] += abs((signed char)filterByte(filter, i));
+
+    int bestFilter = 0;
+    for (int filter = 1; filter < 5; filter++)
+        if (sums[filter] < sums[bestFilter])
+            bestFilter = filter;
+
+    dst[0] = (unsigned char)bestFilter;
+    for (int i = 0; i < rowSize; i++)
+        dst[i+1] = filterByte(bestFilter, i);
+    memcpy(prevRow.data(), row, rowSize);
+}
+
+void PngWriter::WriteRows(const unsigned char* firstRow, const int& rowCount, const int& rowStride)
+{
+    // Filter the given rows.
+    const size_t filteredRowSize = (size_t)width * 4 + 1;
+    filtered.resize(filteredRowSize * rowCount);
+    for (int i = 0; i < rowCount; i++)
+        FilterRow(firstRow + (long long)i * rowStride, filtered.data() + i * filteredRowSize);
+    adler = UpdateAdler32(adler, filtered.data(), filtered.size());
+
+    // Compress them into their own IDAT chunk, the first one starting with the zlib header.
+    std::vector<unsigned char> compressed;
+    if (rowsWritten == 0) {
+        compressed.push_back(0x78);
+        compressed.push_back(0x01);
+    }
+    DeflateBlock(filtered.data(), (int)filtered.size(), compressed);
+    WriteChunk("IDAT", compressed.data(), compressed.size());
+
+    rowsWritten += rowCount;
+    FlushOutput();
+}
+
+bool PngWriter::Close()
+{
+    // End the zlib stream with an empty final block and the adler checksum.
+    std::vector<unsigned char> end = { 0x01, 0x00, 0x00, 0xFF, 0xFF };
+    PutBigEndian(end, adler);
+    WriteChunk("IDAT", end.data(), end.size());
+    WriteChunk("IEND", nullptr, 0);
+    FlushOutput();
+
+    bool success = rowsWritten == height;
+    if (file) {
+        success = !ferror(file) && success;
+        fclose(file);
+        file = nullptr;
+    }
+    return success;
+}
+
+void PngWriter::WriteChunk(const char* type, const unsigned char* data, const size_t& size)
+{
+    PutBigEndian(output, (unsigned int)size);
+    size_t crcStart = output.size();
+    output.insert(output.end(), type, type + 4);
+    if (size > 0)
+        output.insert(output.end(), data, data + size);
+    PutBigEndian(output, UpdateCrc32(0, output.data() + crcStart, size + 4));
+}
+
+void PngWriter::FlushOutput()
+{
+    // In memory mode, the whole file is kept in the output buffer.
+    if (inMemory || !file) return;
+    fwrite(output.data(), 1, output.size(), file);
+    output.clear();
+}
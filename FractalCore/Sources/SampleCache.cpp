@@ -0,0 +1,25 @@
+#include "SampleCache.h"
+#include <cstdio>
+
+std::string SampleCache::MakeKey(const FractalParams& params, const int& imageWidth, const int& imageHeight, const int& x, const int& y, const int& regionWidth, const int& regionHeight)
+{
+    // Doubles are written in hexadecimal so that the key is exact. The julia constant is ignored when unused.
+    const double complexCX = params.juliaSet ? params.complexCX : 0.0;
+    const double complexCY = params.juliaSet ? params.complexCY : 0.0;
+    char key[512];
+    snprintf(key, sizeof(key), "f%d j%d s%a o%a,%a c%a,%a v%a,%a i%d p%d | %dx%d | %d,%d %dx%d",
+             (int)params.fractal, (int)params.juliaSet, params.scale, params.offsetX, params.offsetY, complexCX, complexCY,
+             params.viewWidth, params.viewHeight, params.maxIterations, (int)params.precision,
+             imageWidth, imageHeight, x, y, regionWidth, regionHeight);
+    return key;
+}
+
+unsigned long long SampleCache::HashKey(const std::string& key)
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (const char& c : key) {
+        hash ^= (unsigned char)c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
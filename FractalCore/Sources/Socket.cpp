@@ -0,0 +1,163 @@
+#include "Socket.h"
+#include <cstring>
+#if defined(_WIN32)
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+    #define CloseSocket closesocket
+    #define MSG_NOSIGNAL 0
+    #define poll WSAPoll
+#else
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+    #define CloseSocket close
+#endif
+
+// Winsock has to be initialized once before any socket is created.
+static void InitSockets()
+{
+    #if defined(_WIN32)
+        static bool initialized = []() {
+            WSADATA wsaData;
+            return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+        }();
+    #endif
+}
+
+Socket& Socket::operator=(Socket&& other)
+{
+    if (this != &other) {
+        Close();
+        handle       = other.handle;
+        other.handle = -1;
+    }
+    return *this;
+}
+
+Socket Socket::Connect(const std::string& host, const int& port)
+{
+    InitSockets();
+    addrinfo hints = {}, *addresses = nullptr;
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+        return Socket();
+
+    // Try each address the host name resolves to.
+    Socket result;
+    for (addrinfo* address = addresses; address && !result.IsValid(); address = address->ai_next)
+    {
+        Socket candidate((intptr_t)socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+        if (candidate.IsValid() && connect((int)candidate.handle, address->ai_addr, (int)address->ai_addrlen) == 0)
+            result = std::move(candidate);
+    }
+    freeaddrinfo(addresses);
+    return result;
+}
+
+Socket Socket::Listen(const std::string& address, const int& port)
+{
+    InitSockets();
+    addrinfo hints = {}, *addresses = nullptr;
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_PASSIVE | AI_NUMERICHOST;
+    if (getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+        return Socket();
+
+    Socket result((intptr_t)socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol));
+    int reuse = 1;
+    if (result.IsValid())
+        setsockopt((int)result.handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    if (result.IsValid() && (bind((int)result.handle, addresses->ai_addr, (int)addresses->ai_addrlen) != 0 || listen((int)result.handle, 128) != 0))
+        result.Close();
+    freeaddrinfo(addresses);
+    return result;
+}
+
+Socket Socket::Accept()
+{
+    return Socket((intptr_t)accept((int)handle, nullptr, nullptr));
+}
+
+bool Socket::SendAll(const void* data, const size_t& size)
+{
+    const char* bytes     = (const char*)data;
+    size_t      remaining = size;
+    while (remaining > 0)
+    {
+        const int sent = (int)send((int)handle, bytes, (int)(remaining < (1 << 20) ? remaining : (1 << 20)), MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        bytes     += sent;
+        remaining -= sent;
+    }
+    return true;
+}
+
+bool Socket::ReceiveAll(void* data, const size_t& size)
+{
+    char*  bytes     = (char*)data;
+    size_t remaining = size;
+    while (remaining > 0)
+    {
+        const int received = Receive(bytes, remaining);
+        if (received <= 0) return false;
+        bytes     += received;
+        remaining -= received;
+    }
+    return true;
+}
+
+int Socket::Receive(void* data, const size_t& size)
+{
+    return (int)recv((int)handle, (char*)data, (int)(size < (1 << 20) ? size : (1 << 20)), 0);
+}
+
+bool Socket::IsPeerClosed()
+{
+    // A closed connection is readable, and peeking at it returns 0 bytes.
+    pollfd descriptor = {};
+    descriptor.fd     = (int)handle;
+    descriptor.events = POLLIN;
+    if (poll(&descriptor, 1, 0) <= 0)
+        return false;
+    if (descriptor.revents & (POLLERR | POLLHUP | POLLNVAL))
+        return true;
+    char byte;
+    return recv((int)handle, &byte, 1, MSG_PEEK) <= 0;
+}
+
+bool Socket::WaitForData(const int& milliseconds)
+{
+    pollfd descriptor = {};
+    descriptor.fd     = (int)handle;
+    descriptor.events = POLLIN;
+    return poll(&descriptor, 1, milliseconds) != 0;
+}
+
+void Socket::SetReceiveTimeout(const int& seconds)
+{
+    #if defined(_WIN32)
+        DWORD timeout = seconds * 1000;
+    #else
+        timeval timeout = { seconds, 0 };
+    #endif
+    setsockopt((int)handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+void Socket::SetNoDelay()
+{
+    int noDelay = 1;
+    setsockopt((int)handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+}
+
+void Socket::Close()
+{
+    if (handle >= 0)
+        CloseSocket((int)handle);
+    handle = -1;
+}
@@ -0,0 +1,160 @@
+#include "ThreadPool.h"
+#include <atomic>
+
+ThreadPool::ThreadPool(int threadCount)
+{
+    #if defined(PLATFORM_WEB)
+        threadCount = 0;
+    #else
+        if (threadCount < 0)
+            threadCount = (int)std::thread::hardware_concurrency();
+    #endif
+
+    for (int i = 0; i < threadCount; i++)
+        workers.emplace_back([this]() { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+int ThreadPool::GetNextPriority(const int& running)
+{
+    // A class that waited long enough goes first, then the most urgent class with work, counting the running one.
+    for (int priority = priorityCount - 1; priority > 0; priority--)
+        if (!tasks[priority].empty() && passedOver[priority] >= shareInterval)
+            return priority;
+    for (int priority = 0; priority < priorityCount; priority++)
+        if (!tasks[priority].empty() || priority == running)
+            return priority;
+    return -1;
+}
+
+void ThreadPool::TakeTurn(const int& priority)
+{
+    passedOver[priority] = 0;
+    for (int waiting = priority + 1; waiting < priorityCount; waiting++)
+        if (!tasks[waiting].empty())
+            passedOver[waiting]++;
+}
+
+bool ThreadPool::PopTask(std::function<void()>& task, const int& lowest)
+{
+    // Threads waiting for their own tasks only help with work that is at least as urgent,
+    // so that they don't get stuck in a long task of a less urgent class.
+    int priority = GetNextPriority();
+    if (priority > lowest)
+        for (priority = 0; priority <= lowest && tasks[priority].empty(); priority++) {}
+    if (priority < 0 || priority > lowest) return false;
+    TakeTurn(priority);
+    task = std::move(tasks[priority].front());
+    tasks[priority].pop_front();
+    return true;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return stopping || GetNextPriority() >= 0; });
+            if (!PopTask(task)) return;
+        }
+        task();
+    }
+}
+
+bool ThreadPool::RunNextTask(const TaskPriority& lowest)
+{
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!PopTask(task, (int)lowest)) return false;
+    }
+    task();
+    return true;
+}
+
+bool ThreadPool::Preempt(const TaskPriority& priority, const std::function<void()>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (GetNextPriority((int)priority) == (int)priority)
+        {
+            TakeTurn((int)priority);
+            return false;
+        }
+
+        // Put the task back in front of its class so that it resumes before newer tasks of the same class.
+        tasks[(int)priority].push_front(task);
+        preemptionCount++;
+    }
+    taskAvailable.notify_one();
+    return true;
+}
+
+void ThreadPool::Submit(const std::function<void()>& task, const TaskPriority& priority)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks[(int)priority].push_back(task);
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::ParallelFor(const int& count, const std::function<void(int)>& func, const TaskPriority& priority)
+{
+    // Each task takes the next index until there are none left, or until more urgent work preempts it.
+    std::atomic<int> nextIndex(0), finishedTasks(0);
+    int                     preemptedTasks = 0;
+    std::mutex              doneMutex;
+    std::condition_variable done;
+    const int taskCount = GetThreadCount() < count ? GetThreadCount() : count;
+    std::function<void()> task;
+    task = [&]()
+    {
+        for (int i = nextIndex++; i < count; i = nextIndex++)
+        {
+            func(i);
+            if (nextIndex < count && Preempt(priority, task))
+            {
+                // Wake the caller in case it was waiting with nothing left to help with.
+                std::lock_guard<std::mutex> lock(doneMutex);
+                preemptedTasks++;
+                done.notify_one();
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> lock(doneMutex);
+        finishedTasks++;
+        done.notify_one();
+    };
+    for (int i = 0; i < taskCount; i++)
+        Submit(task, priority);
+
+    // Help with the queued tasks while waiting for the others to finish.
+    int seenPreemptions = 0;
+    while (true)
+    {
+        while (finishedTasks < taskCount && RunNextTask(priority)) {}
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait(lock, [&]() { return finishedTasks == taskCount || preemptedTasks != seenPreemptions; });
+        if (finishedTasks == taskCount) return;
+        seenPreemptions = preemptedTasks;
+    }
+}
+
+size_t ThreadPool::GetPreemptionCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return preemptionCount;
+}
@@ -0,0 +1,29 @@
+#include "ViewState.h"
+#include <cmath>
+
+FractalParams ViewState::GetFractalParams(const double& time, const double& viewWidth, const double& viewHeight) const
+{
+    FractalParams params;
+    params.fractal    = curFractal;
+    params.juliaSet   = renderJuliaSet;
+    params.scale      = scale;
+    params.offsetX    = offset.x;
+    params.offsetY    = offset.y;
+    params.viewWidth  = viewWidth;
+    params.viewHeight = viewHeight;
+
+    // Apply the sine automation to the julia set constant like the shader does.
+    double sineOffset = renderJuliaSet ? sin(time / sineParams.x) * sineParams.y : 0.0;
+    params.complexCX  = complexC.x + sineOffset;
+    params.complexCY  = complexC.y + sineOffset;
+    return params;
+}
+
+ColorParams ViewState::GetColorParams() const
+{
+    ColorParams params;
+    params.hueFg      = customHue.x;
+    params.hueBg      = customHue.y;
+    params.colorWithZ = colorPxWithZ;
+    return params;
+}
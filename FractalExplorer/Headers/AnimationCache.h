@@ -0,0 +1,79 @@
+#pragma once
+#include "MemoryBudget.h"
+#include "ThreadPool.h"
+#include <raylib.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Frames of the sine automation of a julia set, kept compressed so that the animation can be played back without
+// rendering it. The automation adds sin(time / period) * amplitude to the julia constant, so it only goes through the
+// frames of the half cycle where the sine goes from -1 to 1, forth and back. Those frames are rendered once, then
+// compressed by the workers and decompressed a frame ahead of playback.
+class AnimationCache
+{
+public:
+    static const int maxFrames = 256;
+
+private:
+    // Decompressed frame, ready once its task is done.
+    struct DecodedFrame
+    {
+        std::vector<unsigned char> pixels;
+        std::atomic<bool>          ready;
+        ScopedCharge               charge;
+
+        DecodedFrame(MemoryBudget* budget, const int& account, const size_t& bytes) : ready(false), charge(budget, account, bytes) {}
+    };
+
+    ThreadPool&   threadPool;
+    MemoryBudget* memoryBudget;
+    int           budgetAccount;
+    size_t        maxBytes;
+    std::string   key; // Only changed by the main thread.
+    int           width = 0, height = 0;
+    double        period = 1;
+    std::unordered_map<int, std::shared_ptr<DecodedFrame>> decodedFrames;
+
+    // Shared with the workers.
+    std::mutex         mutex;
+    unsigned long long generation = 0; // Advanced when the frames are dropped, so that older tasks drop their results.
+    std::vector<std::shared_ptr<const std::vector<unsigned char>>> frames; // Compressed, null until they are done.
+    std::vector<bool>  framesRequested;
+    size_t             usedBytes = 0;
+    bool               abandoned = false; // The cycle doesn't fit in the cache or the budget reclaimed it.
+
+    void Clear(const bool& abandon);
+    std::shared_ptr<const std::vector<unsigned char>> GetCompressedFrame(const int& frame);
+
+public:
+    AnimationCache(ThreadPool& _threadPool, MemoryBudget* _memoryBudget, const size_t& _maxBytes);
+    ~AnimationCache();
+
+    // Drops the frames unless they are those of the given animation, whose key holds everything that changes its
+    // pixels. The period is the one of the sine automation, in seconds. Returns true if the frames were dropped.
+    bool Start(const std::string& _key, const double& _period, const int& _width, const int& _height);
+
+    // Frame shown at the given time, and time a frame must be rendered at.
+    int    GetFrameIndex(const double& time);
+    double GetFrameTime (const int& frame);
+
+    // Returns a frame that still has to be rendered and marks it as requested, or -1.
+    int  GetMissingFrame();
+
+    // Keeps the pixels of a rendered frame, they are compressed by a worker.
+    void StoreFrame(const int& frame, std::vector<unsigned char>&& pixels);
+
+    // Uploads a frame to the given texture if it was decompressed in time. Returns false if it must be rendered.
+    bool ShowFrame(const int& frame, const Texture2D& target);
+
+    // Starts decompressing the next frame, and frees the other decompressed frames.
+    void Prefetch(const int& shownFrame, const int& nextFrame);
+
+    // Frees the frames.
+    void Unload();
+};
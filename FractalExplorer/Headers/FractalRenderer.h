@@ -1,24 +1,27 @@
 #pragma once
+#include "AnimationCache.h"
+#include "DeepZoomExporter.h"
+#include "DiskSampleCache.h"
+#include "ExrWriter.h"
+#include "JuliaAtlas.h"
+#include "Minimap.h"
+#include "PixelReadback.h"
+#include "PngWriter.h"
+#include "RenderTexturePool.h"
+#include "Supersampler.h"
+#include "ThreadPool.h"
+#include "TileCache.h"
+#include "ViewHistory.h"
+#include "ViewState.h"
 #include <raylib.h>
+#include <atomic>
 #include <chrono>
-
-#define FRACTAL_COUNT 5
-enum class FractalTypes
-{
-    MandelbrotSet,
-    BurningShip,
-    CrescentMoon,
-    NorthStar,
-    LoversFractal,
-};
-FractalTypes operator++(FractalTypes& type);
-FractalTypes operator--(FractalTypes& type);
-
-class FractalNames
-{
-public:
-    static const char* names[FRACTAL_COUNT];
-};
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 enum class ModifiableValues
 {
@@ -31,29 +34,153 @@ enum class ModifiableValues
     ColorStyle,
 };
 
-class FractalRenderer
+enum class ExportFormats
+{
+    Png,
+    RawFloat,
+    DeepZoom,
+};
+
+// Draws the view from tiles computed by worker threads (or with the fractal shader on the web) and exports it. The view state itself comes from the core library.
+class FractalRenderer : public ViewState
 {
 private:
+    // Tile computed on the cpu by the thread pool, waiting for the main loop to upload it.
+    struct ComputedTile
+    {
+        std::string                key;
+        std::vector<unsigned char> pixels;
+        bool                       complete;
+        bool                       prefetch;
+        int                        rowsDone;    // Rows of samples computed before it was cancelled, or all of them.
+        double                     computeTime; // In seconds.
+    };
+
+    // Prefetched tile that was made but hasn't been shown yet.
+    struct UnshownPrefetch
+    {
+        double doneTime;
+        double computeTime;
+    };
+
+    // Last frame drawn with all its tiles, and the view it was drawn at.
+    struct CompleteFrame
+    {
+        RenderTexture renderTexture;
+        bool          valid = false;
+        double        centerX = 0, centerY = 0, pixelsPerUnit = 1;
+    };
+
+    // Snapshot of a view on its way back from the gpu, stored in the history once it is there if the view is still current.
+    struct SnapshotRead
+    {
+        bool        pending = false;
+        std::string historyKey;
+        double      centerX = 0, centerY = 0, pixelsPerUnit = 1;
+    };
+
+    // Deep zoom export, which can take hours and runs on its own thread while the frames go on.
+    struct DeepZoomJob
+    {
+        std::unique_ptr<DeepZoomExporter> exporter;
+        std::thread                       thread;
+        std::atomic<bool>                 done { false };
+        bool                              succeeded = false;
+    };
+
+    // Png or raw float export computed on the cpu, written on its own thread on desktop so that the frames go on meanwhile.
+    struct ImageJob
+    {
+        std::unique_ptr<PngWriter> png; // One of the two.
+        std::unique_ptr<ExrWriter> exr;
+        const char*                filename;
+        FractalParams              params;
+        ColorParams                colorParams;
+        int                        width, height;
+        std::thread                thread;
+        std::atomic<bool>          done { false }, cancelled { false };
+        std::atomic<int>           rowsWritten { 0 };
+        bool                       succeeded = false;
+    };
+
     std::chrono::time_point<std::chrono::system_clock> startTime;
     Vector2       screenSize;
     float         exportScale;
-    RenderTexture screenTexture, exportTexture;
+    RenderTexture screenTexture;
+    CompleteFrame lastCompleteFrame; // Shown moved and scaled to the current view until all its tiles are there.
+    MemoryBudget  memoryBudget;  // Declared before what is charged to it, so that it is destroyed last.
+    int           screenAccount, exportAccount, computeAccount;
+    RenderTexturePool renderTexturePool;
+    TileCache     tileCache;
+    ViewHistory   history;
+    std::unique_ptr<PixelReadback> historyReadback; // Reads the last complete frame back for the snapshots.
+    SnapshotRead  snapshotRead;
+    #if !defined(PLATFORM_WEB)
+        AnimationCache animationCache; // One cycle of the sine automation, the web has no workers to compress it.
+        std::unique_ptr<PixelReadback> animationReadback; // Frames of the cycle on their way back from the gpu.
+    #endif
     Shader        fractalShader;
+    std::mutex    computedTilesMutex;
+    std::vector<ComputedTile> computedTiles;
+    std::unordered_map<std::string, std::shared_ptr<std::atomic<bool>>> tilesInFlight; // With their cancel flag.
+    std::unique_ptr<DiskSampleCache> diskCache; // Samples of the tiles and deep zoom exports, kept between sessions on desktop.
+    std::unique_ptr<DeepZoomJob> deepZoomJob; // Their threads are joined before the thread pool they use is destroyed.
+    std::unique_ptr<ImageJob>    imageJob;
+    ThreadPool    threadPool; // Declared after what its tasks use, so that it is destroyed first.
+    Supersampler  supersampler;
+    JuliaAtlas    juliaAtlas;
+    Minimap       minimap;
     bool          valueModifiedThisFrame = true;
+    bool          tilesPending           = false; // Tiles of the view are still being rendered.
+    bool          minimapOutdated        = true;  // Something other than the position or zoom of the view changed.
+    bool          historyOutdated        = true;  // The view changed since it was last added to the history.
+    double        lastInteractionTime    = 0;
+    double        tileComputeTime        = 0.01;  // Average time a worker takes to compute a tile, in seconds.
+    int           tilesRenderedLastFrame = 0;
+    int           resolutionDrop         = 0;     // Levels below the native one the view is drawn at.
+    double        velocityX = 0, velocityY = 0;   // Speed of the center of the view, in view units per second.
+    double        zoomVelocity = 0;               // In zoom levels per second.
+    double        lastCenterX = 0, lastCenterY = 0, lastScale = 0;
+    std::unordered_map<std::string, UnshownPrefetch> unshownPrefetches;
+    size_t        prefetchHitCount = 0, prefetchWasteCount = 0;
+    double        prefetchWastedTime = 0;         // Worker time spent on prefetched tiles that weren't shown.
+    size_t        cancelledTileCount = 0, cancelledRowCount = 0;
+    double        cancelledTime      = 0;         // Worker time spent on the tiles of the view cancelled before they were done.
     bool          shouldExportImage      = false;
+    bool          resumeExport           = false;
+    bool          exportCheckpointExists = false;
 
-    void ExportToImage();
-    void UpdateShaderTime();
+    bool  IsAnimated();
+    bool  IsIdle();
+    void  SetShaderView(const Vector2& viewSize, const float& viewScale, const Vector2& viewOffset);
+    std::string MakeViewKey();
+    bool  RenderTile(const std::string& viewKey, const int& level, const long long& x, const long long& y);
+    void  ComputeTile(const std::string& viewKey, const int& level, const long long& x, const long long& y, const TaskPriority& priority);
+    void  UpdateViewVelocity();
+    void  UploadComputedTiles();
+    void  CancelTileComputations();
+    bool  DrawTiles();
+    void  DrawTileFallback(const std::string& viewKey, const int& level, const long long& x, const long long& y, const Rectangle& screenRect);
+    void  DrawViewTexture(const RenderTexture& texture, const Rectangle& sourceRect, const Rectangle& screenRect);
+    std::string MakeHistoryKey();
+    void  RecordHistory();
+    void  CollectSnapshot();
+    void  RestoreView(const ViewState& view);
+    void  ExportToImage();
+    void  ExportCpuImage();
+    void  WritePng(ImageJob& job);
+    void  WriteRawData(ImageJob& job);
+    void  UpdateImageExport();
+    void  ExportDeepZoom();
+    void  UpdateDeepZoomExport();
+    void  DrawAnimationFrame(const float& time);
+    float GetTimeSinceStart();
 
 public:
-    float         scale      =   0.f;
-    Vector2       offset     = { 0.f, 0.f };
-    Vector2       complexC   = { -1.35f, 0.05f };
-    Vector2       customHue  = { 2.26893f, 3.14159f };
-    Vector2       sineParams = { 1.f, 0.f };
-    FractalTypes  curFractal     = FractalTypes::MandelbrotSet;
-    bool          renderJuliaSet = false;
-    bool          colorPxWithZ   = false;
+    ExportFormats exportFormat      = ExportFormats::Png;
+    bool          compressRawExport = true;
+    int           tileRendersPerFrame = 24; // Tiles rendered at most each frame on the web, where they can't be computed by workers.
+    float         targetFrameTime     = 1 / 60.f; // While the view changes, its resolution is lowered to be ready within this time.
 
     FractalRenderer(const Vector2& _screenSize, const int& targetFPS);
     ~FractalRenderer();
@@ -61,9 +188,35 @@ public:
     void  SendDataToShader();
     void  Draw();
     void  StartImageExport();
+    void  ResumeDeepZoomExport();
+    void  CancelExport();
     void  SetExportScale(const float& _exportScale);
+    void  SetMemoryCeiling(const size_t& bytes) { memoryBudget.SetCeiling(bytes); }
     void  ValueModifiedThisFrame(const ModifiableValues& modifiedValue);
+    void  Undo();
+    void  Redo();
 
+    FractalParams GetFractalParams();
+    Float2        GetViewPoint(const Vector2& screenPosition); // Point of the complex plane shown at the given pixel.
     Vector2 GetScreenSize () { return screenSize;  }
     float   GetExportScale() { return exportScale; }
+    bool    CanResumeExport() { return exportCheckpointExists && !IsExporting(); }
+    bool    IsExporting() { return deepZoomJob || imageJob; } // Exports run in the background on desktop.
+    float   GetExportProgress(); // From 0 to 1.
+    size_t  GetMemoryCeiling() { return memoryBudget.GetCeiling(); }
+    size_t  GetUsedMemory   () { return memoryBudget.GetUsedBytes(); }
+    size_t  GetCachedTileCount   () { return tileCache.GetTileCount(); }
+    size_t  GetComputingTileCount() { return tilesInFlight.size(); }
+    int     GetResolutionDivisor () { return 1 << resolutionDrop; }
+    int     GetIdleSampleCount   () { return supersampler.GetSampleCount(); }
+    size_t  GetPrefetchHitCount  () { return prefetchHitCount;   }
+    size_t  GetPrefetchWasteCount() { return prefetchWasteCount; }
+    double  GetPrefetchWastedTime() { return prefetchWastedTime; }
+    size_t  GetCancelledTileCount() { return cancelledTileCount; }
+    size_t  GetCancelledRowCount () { return cancelledRowCount;  }
+    double  GetCancelledTime     () { return cancelledTime;      }
+    int&    GetMaxIdleSamples    () { return supersampler.maxSamples; }
+    JuliaAtlas& GetJuliaAtlas    () { return juliaAtlas; }
+    Minimap&    GetMinimap       () { return minimap;    }
+    ViewHistory& GetHistory      () { return history;    }
 };
@@ -0,0 +1,66 @@
+#pragma once
+#include "Colorizer.h"
+#include "IterationSlicer.h"
+#include "ThreadPool.h"
+#include "ViewState.h"
+#include <raylib.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Grid of thumbnails of the julia sets of the complex numbers around a center, to pick the constant of the julia set
+// to look at. The whole grid is one image computed by a single job, split in bands of rows for the thread pool (or a
+// slice of each frame on the web), so that all the workers share it. While a grid is computed the center can keep
+// moving: the next grid is started from the latest center once the current one is shown.
+class JuliaAtlas
+{
+public:
+    static const int columns       = 5; // The grid is square, with the center in the middle thumbnail.
+    static const int thumbnailSize = 64;
+
+private:
+    // Grid being computed. Its tasks keep it alive until they return.
+    struct Grid
+    {
+        FractalParams              params; // Common to all the thumbnails, but the julia constant.
+        ColorParams                colorParams;
+        double                     centerX, centerY, spacing;
+        std::string                key;
+        std::vector<unsigned char> pixels;
+        IterationSlicer            slicer; // Pixels computed so far, on the web.
+        std::atomic<int>           bandsLeft;
+        std::atomic<bool>          cancelled;
+
+        Grid(const FractalParams& _params, const ColorParams& _colorParams, const double& _centerX, const double& _centerY, const double& _spacing, const std::string& _key);
+    };
+
+    ThreadPool&           threadPool;
+    std::shared_ptr<Grid> grid;
+    Texture2D             texture = {};
+    std::string           shownKey;
+    double                shownCenterX = 0, shownCenterY = 0, shownSpacing = 0;
+
+    void        StartGrid();
+    void        ShowGrid();
+    static void   ComputeBand(Grid& grid, const int& band);
+    static Float2 GetThumbnailC(const double& centerX, const double& centerY, const double& spacing, const int& column, const int& row);
+
+public:
+    float spacing = 0.02f; // Distance between the constants of neighbouring thumbnails.
+
+    JuliaAtlas(ThreadPool& _threadPool);
+    ~JuliaAtlas();
+
+    // Shows the grid around the given center once it is computed, and starts computing the next one.
+    void Update(const FractalTypes& fractal, const ColorParams& colorParams, const double& centerX, const double& centerY);
+
+    // Cancels the grid being computed and frees the texture, which must be done before the window is closed.
+    void Unload();
+
+    bool             HasImage  () { return texture.id != 0; }
+    const Texture2D& GetTexture() { return texture; }
+
+    // Julia constant of a thumbnail of the shown grid.
+    Float2 GetComplexC(const int& column, const int& row) { return GetThumbnailC(shownCenterX, shownCenterY, shownSpacing, column, row); }
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include "Colorizer.h"
+#include "IterationSlicer.h"
+#include "ThreadPool.h"
+#include "ViewState.h"
+#include <raylib.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Small overview of the whole fractal, kept for each fractal, julia constant and colors that were shown so that it
+// is never rendered again when only the main view moves. It is first computed with one sample per block of pixels,
+// then refined pass after pass in idle time by halving the blocks until every pixel has its own sample. Nothing is
+// done each frame once it is complete.
+class Minimap
+{
+public:
+    static const int width  = 240;
+    static const int height = 135;
+    static constexpr double scale = -0.5; // Zoom level of the overview, which shows the whole fractal.
+
+private:
+    // Pass of the refinement of an overview. Its tasks keep it alive until they return.
+    struct Refinement
+    {
+        FractalParams              params;
+        ColorParams                colorParams;
+        std::string                key;
+        std::vector<unsigned char> pixels;
+        int                        blockSize;   // Pixels filled by each sample of the current pass.
+        bool                       passStarted = false;
+        IterationSlicer            slicer; // Samples of the pass computed so far, on the web.
+        std::atomic<int>           bandsLeft;
+        std::atomic<bool>          cancelled;
+
+        Refinement(const FractalParams& _params, const ColorParams& _colorParams, const std::string& _key);
+    };
+
+    struct Overview
+    {
+        Texture2D          texture  = {};
+        bool               complete = false;
+        unsigned long long lastUse  = 0;
+    };
+
+    ThreadPool&                 threadPool;
+    std::unordered_map<std::string, Overview> overviews;
+    std::shared_ptr<Refinement> refinement;
+    std::string                 shownKey;
+    unsigned long long          useCount = 0;
+
+    void        StartPass();
+    void        FinishPass();
+    void        Evict();
+    static void ComputeBand(Refinement& refinement, const int& band);
+    static void FillBlock  (Refinement& refinement, const int& x, const int& y, const unsigned char* rgba);
+    static bool GetSamplePosition(const int& blockSize, const int& sample, int& x, int& y);
+
+public:
+    Minimap(ThreadPool& _threadPool);
+    ~Minimap();
+
+    // Shows the overview of the given view, whose position and zoom are ignored. The key holds everything else that
+    // changes its pixels. The overview is taken from the cache, or its refinement is started.
+    void Show(const std::string& key, const FractalParams& params, const ColorParams& colorParams);
+
+    // Advances the refinement of the shown overview, its finer passes are only started when idle.
+    void Update(const bool& idle);
+
+    // Frees the textures, which must be done before the window is closed.
+    void Unload();
+
+    // Returns the texture of the shown overview, or nullptr if its first pass isn't done yet.
+    const Texture2D* GetTexture();
+
+    // Conversions between the pixels of the overview and the points of the complex plane they show.
+    static Float2  GetPoint(const Vector2& pixel);
+    static Vector2 GetPixel(const Float2& point);
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <raylib.h>
+#include <functional>
+#include <vector>
+
+// Called with blocks of rows in top to bottom order. The rows are stored bottom-up, so rowStride is negative.
+using ReadbackCallback = std::function<void(const unsigned char* firstRow, const int& rowCount, const int& rowStride)>;
+
+// Reads a rendertexture back to the cpu in blocks of rows.
+// When pixel buffer objects are available, several blocks are copied asynchronously so that the callback
+// processes one block while the gpu copies the next ones. Otherwise, each block is read synchronously.
+// Reads of the whole target can also be collected by a later frame, so that the frame that starts them never waits
+// for the gpu. Each of them takes a pixel buffer until it is collected.
+class PixelReadback
+{
+private:
+    static const int bufferCount = 3;
+
+    RenderTexture target;
+    int           chunkRows;
+    bool          usePixelBuffers;
+    unsigned int  pixelBuffers[bufferCount] = { 0 };
+    void*         fences      [bufferCount] = { nullptr };
+    int           readTags    [bufferCount] = { 0 };   // Of the reads to collect, by buffer.
+    bool          cpuReadPending = false;               // The synchronous read waits in cpuBuffer to be collected.
+    std::vector<unsigned char> cpuBuffer;
+
+    int  GetChunkCount() { return (target.texture.height + chunkRows - 1) / chunkRows; }
+    int  GetChunkRowCount(const int& chunk);
+    void IssueRead(const int& chunk, const int& slot);
+    void ReadSynchronously(const int& chunk, const ReadbackCallback& callback);
+
+public:
+    PixelReadback(const RenderTexture& _target, const int& _chunkRows = 256);
+    ~PixelReadback();
+
+    void ReadAll(const ReadbackCallback& callback);
+
+    // Starts reading the whole target, which must fit in a single block of rows. A read can't start while all the
+    // buffers are taken by reads that weren't collected, StartRead then returns false.
+    bool CanStartRead();
+    bool StartRead(const int& tag);
+
+    // Calls the callback with the tag and rows of each read the gpu is done with, without waiting for the others.
+    void CollectReads(const std::function<void(const int& tag, const unsigned char* firstRow, const int& rowCount, const int& rowStride)>& callback);
+
+    // Drops the reads that weren't collected.
+    void CancelReads();
+
+    // Memory used by the buffers the rows are copied to.
+    size_t GetBufferBytes() { return (size_t)target.texture.width * chunkRows * 4 * (usePixelBuffers ? bufferCount : 1); }
+};
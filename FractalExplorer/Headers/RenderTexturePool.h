@@ -0,0 +1,44 @@
+#pragma once
+#include "MemoryBudget.h"
+#include <raylib.h>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Keeps released rendertextures so that later requests of the same size can reuse them instead of reallocating.
+// Pooled textures are unloaded once they have been idle for too long, when the pool grows over its byte budget,
+// when an allocation fails or when the memory budget runs short.
+class RenderTexturePool
+{
+private:
+    struct PooledTexture
+    {
+        RenderTexture renderTexture;
+        double        releaseTime;
+    };
+    std::vector<PooledTexture> pooledTextures;
+    size_t maxPooledBytes;
+    double maxIdleTime;
+    MemoryBudget*   memoryBudget  = nullptr;
+    int             budgetAccount = -1;
+    std::thread::id ownerThread; // Rendertextures can only be unloaded on the thread of the OpenGL context.
+
+    void Unload(const RenderTexture& renderTexture);
+
+public:
+    RenderTexturePool(const size_t& _maxPooledBytes, const double& _maxIdleTime);
+    ~RenderTexturePool();
+
+    RenderTexture Acquire(const int& width, const int& height);
+    void          Release(const RenderTexture& renderTexture);
+    void          Update();
+    void          Trim(const size_t& maxBytes);
+
+    // Charges the textures of the pool, pooled or in use, to an account of the given budget, which can then unload
+    // the pooled ones. Must be called before the pool is used.
+    void          SetMemoryBudget(MemoryBudget* _memoryBudget, const std::string& accountName);
+
+    size_t        GetPooledBytes();
+    static size_t GetByteSize(const RenderTexture& renderTexture);
+    static size_t GetByteSize(const int& width, const int& height);
+};
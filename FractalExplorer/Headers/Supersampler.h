@@ -0,0 +1,65 @@
+#pragma once
+#include "Colorizer.h"
+#include "IterationSlicer.h"
+#include "MemoryBudget.h"
+#include "ThreadPool.h"
+#include <raylib.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Refines a still view by accumulating jittered samples over successive passes, each adding one sample per pixel,
+// so that it converges to an antialiased image while the user looks at it. The passes are computed in bands of rows
+// by the thread pool, or for a slice of each frame on the web, and the average is uploaded after each pass.
+class Supersampler
+{
+private:
+    // Samples of one view. The tasks of an accumulation that was restarted keep it alive until they return.
+    struct Accumulation
+    {
+        FractalParams              params;
+        ColorParams                colorParams;
+        int                        width, height;
+        ScopedCharge               charge;
+        std::vector<float>         sums;   // Sum of the RGB colors of each pixel, over the passes.
+        std::vector<unsigned char> pixels; // Average RGBA color of each pixel after the last pass.
+        int                        passCount = 0;
+        std::atomic<int>           bandsLeft;
+        std::atomic<bool>          cancelled;
+        IterationSlicer            slicer; // Pixels of the pass computed so far, on the web.
+
+        Accumulation(const FractalParams& _params, const ColorParams& _colorParams, const int& _width, const int& _height, MemoryBudget* budget, const int& account);
+    };
+
+    ThreadPool&   threadPool;
+    MemoryBudget* memoryBudget;
+    int           budgetAccount;
+    std::shared_ptr<Accumulation> accumulation;
+    Texture2D     texture      = {};
+    int           sampleCount  = 0; // Samples per pixel in the texture.
+
+    void        StartPass();
+    void        FreeTexture();
+    static void ComputeBand(Accumulation& accumulation, const int& band);
+    static void AddSample  (Accumulation& accumulation, const size_t& pixel, const unsigned char* rgba);
+
+public:
+    int maxSamples = 16; // Samples per pixel the accumulation stops at, 0 disables it.
+
+    Supersampler(ThreadPool& _threadPool, MemoryBudget* _memoryBudget);
+    ~Supersampler();
+
+    // Starts or continues the accumulation of the given view, as an image of the given size. Must be called with the
+    // same view until Restart.
+    void Update(const FractalParams& params, const ColorParams& colorParams, const int& width, const int& height);
+
+    // Drops the accumulation and cancels its passes, for when the view changes.
+    void Restart();
+
+    // Also frees the texture, which must be done before the window is closed.
+    void Unload();
+
+    bool             HasImage      () { return sampleCount > 0; }
+    const Texture2D& GetTexture    () { return texture;     }
+    int              GetSampleCount() { return sampleCount; }
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "MemoryBudget.h"
+#include <raylib.h>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Keeps the tiles of the quadtree the view is drawn from, so that regions that are shown again don't have to be
+// rendered again. Tiles are square rendertextures of a fixed size. Once the cache is full, the least recently used
+// tiles are reused for the new ones. They are also unloaded when the memory budget runs short.
+class TileCache
+{
+public:
+    static const int tileSize = 256;
+
+private:
+    struct Tile
+    {
+        std::string   key;
+        RenderTexture renderTexture;
+    };
+    std::list<Tile> tiles; // Most recently used first.
+    std::unordered_map<std::string, std::list<Tile>::iterator> index;
+    size_t          maxBytes;
+    MemoryBudget*   memoryBudget  = nullptr;
+    int             budgetAccount = -1;
+    std::thread::id ownerThread; // Rendertextures can only be unloaded on the thread of the OpenGL context.
+
+    void Unload(const RenderTexture& renderTexture);
+
+public:
+    TileCache(const size_t& _maxBytes);
+    ~TileCache();
+
+    // Charges the tiles to an account of the given budget, which can then unload them. Must be called before the
+    // cache is used.
+    void SetMemoryBudget(MemoryBudget* _memoryBudget, const std::string& accountName);
+
+    // Returns the tile stored under the given key and marks it as used, or nullptr. The pointer stays valid until
+    // the next call to Add or Trim.
+    const RenderTexture* Find(const std::string& key);
+
+    // Returns the rendertexture a new tile must be drawn in, stored under the given key, or one with an id of 0 if
+    // it couldn't be allocated.
+    RenderTexture Add(const std::string& key);
+
+    // Unloads tiles until the cache holds at most the given number of bytes.
+    void   Trim(const size_t& bytes);
+    size_t GetUsedBytes() { return tiles.size() * GetTileBytes(); }
+    size_t GetTileCount() { return tiles.size(); }
+
+    // Returns the key of a tile of the quadtree, the view key holding everything that changes its pixels.
+    static std::string MakeKey(const std::string& viewKey, const int& level, const long long& x, const long long& y);
+    static size_t      GetTileBytes();
+};
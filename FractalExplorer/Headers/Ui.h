@@ -9,6 +9,7 @@ private:
     FractalRenderer& fractalRenderer;
     bool    interactingWithUi = false;
     bool    popupOpen         = true;
+    Vector2 atlasCenter       = { -1.35f, 0.05f }; // Constant the julia atlas is centered on.
 
 public:
     Vector2 mouseDelta        = { 0, 0 };
@@ -0,0 +1,76 @@
+#pragma once
+#include "LruCache.h"
+#include "ThreadPool.h"
+#include "ViewState.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Views the user stopped at, to go back and forth between them. Each view can keep a compressed snapshot of its
+// complete frame, so that going back to it shows it at once, even if its tiles were evicted. The snapshots are kept
+// in a cache of their own and are the first thing to go when memory runs short, the views are then rendered again.
+class ViewHistory
+{
+public:
+    static const size_t maxViews = 100;
+
+    // Frame of a view, as the raw pixels of the screen rendertexture compressed with deflate.
+    struct Snapshot
+    {
+        std::vector<unsigned char> data;
+        int                        width, height;
+        double                     centerX, centerY, pixelsPerUnit; // Where the frame was drawn.
+    };
+
+private:
+    struct View
+    {
+        ViewState   view;
+        std::string key;
+        std::string snapshotKey;
+        std::shared_ptr<std::atomic<bool>> compressing; // Its snapshot is being compressed, set to false once it is done.
+    };
+
+    ThreadPool&        threadPool;
+    LruCache<Snapshot> snapshots;
+    std::vector<View>  views;
+    size_t             current    = 0; // Index of the view that is shown.
+    unsigned long long snapshotId = 0;
+
+    static std::shared_ptr<const Snapshot> Compress(const std::vector<unsigned char>& pixels, const int& width, const int& height, const double& centerX, const double& centerY, const double& pixelsPerUnit);
+
+public:
+    ViewHistory(ThreadPool& _threadPool, const size_t& maxSnapshotBytes);
+
+    // Charges the snapshots to an account of the given budget. Must be called before the history is used.
+    void SetMemoryBudget(MemoryBudget* memoryBudget, const std::string& accountName) { snapshots.SetMemoryBudget(memoryBudget, accountName); }
+
+    // Adds a view after the current one, dropping the views that were undone. The key holds everything that changes
+    // its pixels and position. Returns false if it is the current view.
+    bool Push(const ViewState& view, const std::string& key);
+
+    // Keeps the given pixels as the snapshot of the current view. They are compressed by a worker (or right away on the web).
+    void StoreSnapshot(std::vector<unsigned char>&& pixels, const int& width, const int& height, const double& centerX, const double& centerY, const double& pixelsPerUnit);
+
+    // Current view, or nullptr if the history is empty, and whether it has the given key.
+    const ViewState* GetCurrent();
+    bool             IsCurrent(const std::string& key) { return !views.empty() && views[current].key == key; }
+
+    // Moves to the previous or next view and returns it, or nullptr if there is none.
+    const ViewState* Undo();
+    const ViewState* Redo();
+
+    // Snapshot of the current view, or nullptr if it was evicted or isn't compressed yet.
+    std::shared_ptr<const Snapshot> FindSnapshot();
+    bool HasSnapshot();
+
+    // Whether the snapshot of the current view was stored and is still being compressed.
+    bool IsSnapshotPending();
+
+    bool   CanUndo     () { return current > 0; }
+    bool   CanRedo     () { return current + 1 < views.size(); }
+    size_t GetViewCount() { return views.size(); }
+    size_t GetPosition () { return current; }
+};
@@ -0,0 +1,173 @@
+#include "AnimationCache.h"
+#include <algorithm>
+#include <cmath>
+
+const int AnimationCache::maxFrames;
+
+// Frames of the half cycle per second of animation, fewer are rendered for the automations slower than
+// maxFrames / framesPerSecond / pi seconds per radian.
+static const double framesPerSecond = 60;
+
+AnimationCache::AnimationCache(ThreadPool& _threadPool, MemoryBudget* _memoryBudget, const size_t& _maxBytes)
+    : threadPool(_threadPool), memoryBudget(_memoryBudget), maxBytes(_maxBytes)
+{
+    budgetAccount = memoryBudget->Register("Animation frames", [this](const size_t& bytes) { Clear(true); });
+}
+
+AnimationCache::~AnimationCache()
+{
+    Unload();
+    memoryBudget->Unregister(budgetAccount);
+}
+
+void AnimationCache::Unload()
+{
+    decodedFrames.clear();
+    Clear(true);
+    key.clear();
+}
+
+void AnimationCache::Clear(const bool& abandon)
+{
+    size_t freedBytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        std::fill(frames.begin(), frames.end(), nullptr);
+        freedBytes = usedBytes;
+        usedBytes  = 0;
+        abandoned  = abandon;
+    }
+    if (freedBytes > 0)
+        memoryBudget->Credit(budgetAccount, freedBytes);
+}
+
+bool AnimationCache::Start(const std::string& _key, const double& _period, const int& _width, const int& _height)
+{
+    if (key == _key)
+        return false;
+    key    = _key;
+    period = _period;
+    width  = _width;
+    height = _height;
+    decodedFrames.clear();
+    Clear(false);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const int frameCount = std::clamp((int)ceil(PI * period * framesPerSecond) + 1, 2, maxFrames);
+    frames.assign(frameCount, nullptr);
+    framesRequested.assign(frameCount, false);
+    return true;
+}
+
+int AnimationCache::GetFrameIndex(const double& time)
+{
+    // Fold the phase onto the half cycle from -pi/2 to pi/2, which has the same values of the sine.
+    const double phase = asin(sin(time / period));
+    const int    count = (int)frames.size();
+    return std::clamp((int)lround((phase + PI / 2) / PI * (count - 1)), 0, count - 1);
+}
+
+double AnimationCache::GetFrameTime(const int& frame)
+{
+    return (-PI / 2 + PI * frame / (frames.size() - 1)) * period;
+}
+
+int AnimationCache::GetMissingFrame()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (abandoned)
+        return -1;
+    for (size_t frame = 0; frame < framesRequested.size(); frame++) {
+        if (!framesRequested[frame]) {
+            framesRequested[frame] = true;
+            return (int)frame;
+        }
+    }
+    return -1;
+}
+
+void AnimationCache::StoreFrame(const int& frame, std::vector<unsigned char>&& pixels)
+{
+    unsigned long long frameGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        frameGeneration = generation;
+    }
+    std::shared_ptr<std::vector<unsigned char>> framePixels = std::make_shared<std::vector<unsigned char>>(std::move(pixels));
+    threadPool.Submit([this, frame, framePixels, frameGeneration]()
+    {
+        int compressedSize = 0;
+        unsigned char* compressed = CompressData(framePixels->data(), (int)framePixels->size(), &compressedSize);
+        if (!compressed)
+            return;
+        std::shared_ptr<const std::vector<unsigned char>> data = std::make_shared<const std::vector<unsigned char>>(compressed, compressed + compressedSize);
+        MemFree(compressed);
+
+        // The frame is charged before it is published, so that a Clear in between never credits it. Once the cache is
+        // full the cycle won't fit, the frames that are there are still played back.
+        memoryBudget->Charge(budgetAccount, data->size());
+        bool published = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (generation == frameGeneration && !abandoned)
+            {
+                if (usedBytes + data->size() > maxBytes) {
+                    abandoned = true;
+                }
+                else {
+                    frames[frame] = data;
+                    usedBytes    += data->size();
+                    published     = true;
+                }
+            }
+        }
+        if (!published)
+            memoryBudget->Credit(budgetAccount, data->size());
+    }, TaskPriority::Prefetch);
+}
+
+std::shared_ptr<const std::vector<unsigned char>> AnimationCache::GetCompressedFrame(const int& frame)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return frame >= 0 && frame < (int)frames.size() ? frames[frame] : nullptr;
+}
+
+bool AnimationCache::ShowFrame(const int& frame, const Texture2D& target)
+{
+    // Decompressing the frame now would take longer than rendering it.
+    auto decoded = decodedFrames.find(frame);
+    if (decoded == decodedFrames.end() || !decoded->second->ready || decoded->second->pixels.empty())
+        return false;
+    UpdateTexture(target, decoded->second->pixels.data());
+    return true;
+}
+
+void AnimationCache::Prefetch(const int& shownFrame, const int& nextFrame)
+{
+    for (auto it = decodedFrames.begin(); it != decodedFrames.end();) {
+        if (it->first != shownFrame && it->first != nextFrame)
+            it = decodedFrames.erase(it);
+        else
+            it++;
+    }
+    if (decodedFrames.count(nextFrame))
+        return;
+    std::shared_ptr<const std::vector<unsigned char>> compressed = GetCompressedFrame(nextFrame);
+    if (!compressed)
+        return;
+
+    // The user is watching the animation, so it goes before everything else.
+    const size_t frameBytes = (size_t)width * height * 4;
+    std::shared_ptr<DecodedFrame> decoded = std::make_shared<DecodedFrame>(memoryBudget, budgetAccount, frameBytes);
+    decodedFrames[nextFrame] = decoded;
+    threadPool.Submit([decoded, compressed, frameBytes]()
+    {
+        int size = 0;
+        unsigned char* pixels = DecompressData(compressed->data(), (int)compressed->size(), &size);
+        if (pixels && (size_t)size == frameBytes)
+            decoded->pixels.assign(pixels, pixels + size);
+        MemFree(pixels);
+        decoded->ready = true;
+    }, TaskPriority::Interactive);
+}
@@ -1,36 +1,80 @@
 #include "FractalRenderer.h"
+#include "Colorizer.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <string>
+#include <vector>
 #include <rlgl.h>
-#include <external/stb_image.h>
-#include <external/stb_image_write.h>
 #if defined(PLATFORM_WEB)
     #include <emscripten/emscripten.h>
 #endif
 
-const char* FractalNames::names[FRACTAL_COUNT] = { "Mandelbrot Set", "Burning Ship", "Crescent Moon", "North Star", "Lovers' Fractal" };
+// The web build starts small and grows its heap when needed, the ceiling keeps that growth in check.
+#if defined(PLATFORM_WEB)
+    static const size_t defaultMemoryCeiling = (size_t)512 << 20;
+    static const size_t maxTileCacheBytes    = (size_t)128 << 20;
+    static const size_t maxSnapshotBytes     = (size_t)32  << 20;
+#else
+    static const size_t defaultMemoryCeiling = (size_t)1024 << 20;
+    static const size_t maxTileCacheBytes    = (size_t)256 << 20;
+    static const size_t maxSnapshotBytes     = (size_t)128 << 20;
+    static const size_t maxAnimationBytes    = (size_t)512 << 20;
+    static const size_t maxDiskCacheBytes    = (size_t)2048 << 20; // Shared with fractal-render and fractal-server.
+#endif
 
-FractalTypes operator++(FractalTypes& type)
-{
-    type = static_cast<FractalTypes>(((int)type + 1) % FRACTAL_COUNT);
-    return type;
-}
-FractalTypes operator--(FractalTypes& type)
+// Missing tiles are drawn from cached tiles up to this many levels coarser.
+static const int maxFallbackLevels = 8;
+
+// Tiles this many levels coarser than the shown ones are rendered first, so that the view quickly has something to show.
+static const int coarseLevelOffset = 2;
+
+// While the view changes, it can be drawn up to this many levels below the native resolution (each level halves it).
+// The view counts as changing for a short while after the last change.
+static const int    maxResolutionDrop = 3;
+static const double interactionDelay  = 0.2;
+
+// Tiles are prefetched where the view will be this many seconds later if it keeps moving at the same speed, when that
+// is far enough from where it is. Prefetched tiles that haven't been shown after prefetchExpiry seconds count as wasted.
+static const double prefetchTime      = 0.3;
+static const double minPrefetchPixels = 16;
+static const double minPrefetchZoom   = 0.05;
+static const double prefetchExpiry    = 2.0;
+static const int    maxPrefetchTiles  = 48;
+
+// Frames of the sine automation rendered for the animation cache each frame, on top of the one that is shown.
+static const int animationFramesPerFrame = 2;
+
+// Weight of each frame in the measured speed of the view, which smooths out the steps of the inputs.
+static const double velocitySmoothing = 0.3;
+
+// Frames that take longer than this times the target frame time render fewer tiles on the web.
+static const float frameTimeTolerance   = 1.2f;
+static const int   maxTileRendersPerFrame = 64;
+
+// Width of the tiles of a level of the quadtree, in units of the view. Level l has 2^l tiles over the height of the
+// screen at a zoom of 0.
+static double GetTileWidth(const int& level)
 {
-    type = static_cast<FractalTypes>((int)type - 1 >= 0 ? (int)type - 1 : FRACTAL_COUNT - 1);
-    return type;
+    return ldexp(2.0, -level);
 }
 
+// Export bands are never made smaller than this, even when the budget is used up.
+static const int minExportBandRows = 256;
 
 FractalRenderer::FractalRenderer(const Vector2& _screenSize, const int& targetFPS)
-    :  exportScale(4), screenSize(_screenSize)
+    :  exportScale(4), screenSize(_screenSize), memoryBudget(defaultMemoryCeiling), renderTexturePool(256 << 20, 30.0), tileCache(maxTileCacheBytes),
+       history(threadPool, maxSnapshotBytes),
+       #if !defined(PLATFORM_WEB)
+           animationCache(threadPool, &memoryBudget, maxAnimationBytes),
+       #endif
+       supersampler(threadPool, &memoryBudget), juliaAtlas(threadPool), minimap(threadPool)
 {
     startTime = std::chrono::system_clock::now();
 
     // Initialize raylib.
     InitWindow(screenSize.x < 0 ? 1728 : (int)screenSize.x, screenSize.y < 0 ? 972 : (int)screenSize.y, "Fractal Explorer");
     SetTargetFPS(targetFPS);
-    stbi_flip_vertically_on_write(true);
 
     // Get the monitor size and resize the window.
     if (screenSize.x < 0 || screenSize.y < 0)
@@ -40,19 +84,64 @@ FractalRenderer::FractalRenderer(const Vector2& _screenSize, const int& targetFP
         SetWindowPosition(0, 30);
     }
 
-    // Load rendertextures and shaders.
+    // Load rendertextures and shaders. The export rendertexture is only allocated when an export starts.
+    screenAccount = memoryBudget.Register("Screen");
+    exportAccount = memoryBudget.Register("Export buffers");
+    computeAccount = memoryBudget.Register("Tiles being computed");
+    renderTexturePool.SetMemoryBudget(&memoryBudget, "Export rendertextures");
+    tileCache.SetMemoryBudget(&memoryBudget, "Tiles");
+    history.SetMemoryBudget(&memoryBudget, "View history");
     screenTexture = LoadRenderTexture((int)screenSize.x, (int)screenSize.y);
-    exportTexture = LoadRenderTexture((int)(1920 * exportScale), (int)(1080 * exportScale));
+    lastCompleteFrame.renderTexture = LoadRenderTexture((int)screenSize.x, (int)screenSize.y);
+    SetTextureFilter(lastCompleteFrame.renderTexture.texture, TEXTURE_FILTER_BILINEAR);
+    memoryBudget.Charge(screenAccount, RenderTexturePool::GetByteSize(screenTexture) * 2);
+    historyReadback = std::make_unique<PixelReadback>(lastCompleteFrame.renderTexture, lastCompleteFrame.renderTexture.texture.height);
+    memoryBudget.Charge(screenAccount, historyReadback->GetBufferBytes());
+    #if !defined(PLATFORM_WEB)
+        animationReadback = std::make_unique<PixelReadback>(screenTexture, screenTexture.texture.height);
+        memoryBudget.Charge(screenAccount, animationReadback->GetBufferBytes());
+    #endif
     fractalShader = LoadShader(NULL, "Shaders/Fractal.frag");
     SetShaderValue(fractalShader, GetShaderLocation(fractalShader, "screenSize"), &screenSize, SHADER_UNIFORM_VEC2);
     SendDataToShader();
+
+    // Check if a deep zoom export was interrupted, and open the disk cache, which the tiles go without if it can't be opened.
+    #if !defined(PLATFORM_WEB)
+        exportCheckpointExists = DeepZoomExporter::HasCheckpoint("fractal");
+        diskCache = std::make_unique<DiskSampleCache>(DiskSampleCache::GetDefaultDirectory(), maxDiskCacheBytes);
+        if (!diskCache->IsOpen()) {
+            TraceLog(LOG_WARNING, "Unable to open the sample cache in %s.", DiskSampleCache::GetDefaultDirectory().c_str());
+            diskCache.reset();
+        }
+    #endif
 }
 
 FractalRenderer::~FractalRenderer()
 {
+    // A deep zoom export being made is stopped with its progress saved, so that it can be resumed next time.
+    CancelExport();
+    if (deepZoomJob)
+        deepZoomJob->thread.join();
+    if (imageJob) {
+        imageJob->thread.join();
+        std::remove(imageJob->filename);
+    }
+
+    // The workers finish the queued tasks before stopping, the cancelled ones return at once.
+    CancelTileComputations();
+    renderTexturePool.Trim(0);
+    tileCache.Trim(0);
+    supersampler.Unload();
+    juliaAtlas.Unload();
+    minimap.Unload();
+    historyReadback.reset();
+    #if !defined(PLATFORM_WEB)
+        animationCache.Unload();
+        animationReadback.reset();
+    #endif
     CloseWindow();
     UnloadRenderTexture(screenTexture);
-    UnloadRenderTexture(exportTexture);
+    UnloadRenderTexture(lastCompleteFrame.renderTexture);
 }
 
 void FractalRenderer::SendDataToShader()
@@ -71,82 +160,920 @@ void FractalRenderer::SendDataToShader()
     SetShaderValue(fractalShader, GetShaderLocation(fractalShader, "customHue" ), &customHue,     SHADER_UNIFORM_VEC2);
 }
 
-void FractalRenderer::UpdateShaderTime()
+float FractalRenderer::GetTimeSinceStart()
 {
-    float timeSinceStart = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startTime).count() / 1000.f;
-    SetShaderValue(fractalShader, GetShaderLocation(fractalShader, "time"), &timeSinceStart, SHADER_UNIFORM_FLOAT);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startTime).count() / 1000.f;
 }
 
-void FractalRenderer::Draw()
+void FractalRenderer::DrawAnimationFrame(const float& time)
 {
-    if (valueModifiedThisFrame || renderJuliaSet)
+    SetShaderValue(fractalShader, GetShaderLocation(fractalShader, "time"), &time, SHADER_UNIFORM_FLOAT);
+    BeginTextureMode(screenTexture);
     {
-        if (renderJuliaSet) UpdateShaderTime();
-
-        // Draw the current fractal onto the screen rendertexture.
-        BeginTextureMode(screenTexture);
+        ClearBackground(BLACK);
+        BeginShaderMode(fractalShader);
         {
-            ClearBackground(BLACK);
-            BeginShaderMode(fractalShader);
+            DrawTextureRec(screenTexture.texture, { 0, 0, screenSize.x, -screenSize.y }, { 0, 0 }, WHITE);
+        }
+        EndShaderMode();
+    }
+    EndTextureMode();
+}
+
+void FractalRenderer::Draw()
+{
+    UpdateViewVelocity();
+    if (IsAnimated())
+    {
+        // The sine automation changes the julia set every frame, so it is drawn directly instead of from tiles.
+        CancelTileComputations();
+        const float time = GetTimeSinceStart();
+        #if defined(PLATFORM_WEB)
+            DrawAnimationFrame(time);
+        #else
+            // The automation is periodic, so once the frames of a cycle are cached it is played back from them.
+            // While the view is still, a few missing frames are rendered each frame and copied to pixel buffers, which
+            // are collected by the next frames once the gpu is done with them.
+            char animationKey[128];
+            snprintf(animationKey, sizeof(animationKey), " | o%a,%a s%a p%a,%a", offset.x, offset.y, scale, sineParams.x, sineParams.y);
+            if (animationCache.Start(MakeViewKey() + animationKey, sineParams.x, (int)screenSize.x, (int)screenSize.y))
+                animationReadback->CancelReads(); // They were frames of another animation.
+            animationReadback->CollectReads([&](const int& frame, const unsigned char* firstRow, const int& rowCount, const int& rowStride)
             {
-                DrawTextureRec(screenTexture.texture, { 0, 0, screenSize.x, -screenSize.y }, { 0, 0 }, WHITE);
+                // The frames are kept in the row order of the texture, which is the one UpdateTexture expects.
+                const unsigned char* bottomRow = firstRow + (ptrdiff_t)(rowCount - 1) * rowStride;
+                animationCache.StoreFrame(frame, std::vector<unsigned char>(bottomRow, bottomRow + (size_t)rowCount * -rowStride));
+            });
+            for (int i = 0; i < animationFramesPerFrame && GetTime() - lastInteractionTime >= interactionDelay && animationReadback->CanStartRead(); i++)
+            {
+                const int missingFrame = animationCache.GetMissingFrame();
+                if (missingFrame < 0)
+                    break;
+                DrawAnimationFrame((float)animationCache.GetFrameTime(missingFrame));
+                animationReadback->StartRead(missingFrame);
             }
-            EndShaderMode();
-        }
-        EndTextureMode();
+
+            const int shownFrame = animationCache.GetFrameIndex(time);
+            if (animationCache.ShowFrame(shownFrame, screenTexture.texture))
+                SetShaderValue(fractalShader, GetShaderLocation(fractalShader, "time"), &time, SHADER_UNIFORM_FLOAT);
+            else
+                DrawAnimationFrame(time);
+            animationCache.Prefetch(shownFrame, animationCache.GetFrameIndex(time + GetFrameTime()));
+        #endif
+    }
+    else if (valueModifiedThisFrame || tilesPending || !tilesInFlight.empty())
+    {
+        // Draw the current fractal from the tiles of the quadtree, rendering the missing ones.
+        tilesPending = !DrawTiles();
     }
     valueModifiedThisFrame = false;
 
-    // Draw the fractal rendertexture on the screen.
+    // Once the view is complete and still, keep refining it with more samples per pixel.
+    const bool idle = IsIdle();
+    if (idle)
+        supersampler.Update(GetFractalParams(), GetColorParams(), (int)screenSize.x, (int)screenSize.y);
+
+    // The overview only depends on what the view shows, not on where it is.
+    if (minimapOutdated) {
+        minimap.Show(MakeViewKey(), ViewState::GetFractalParams(0.0, Minimap::width, Minimap::height), GetColorParams());
+        minimapOutdated = false;
+    }
+    minimap.Update(idle);
+
+    // Once the view is still, add it to the history.
+    CollectSnapshot();
+    if (idle && historyOutdated) {
+        RecordHistory();
+        historyOutdated = false;
+    }
+
+    // Draw the fractal rendertexture, or its supersampled version, on the screen.
     ClearBackground(BLACK);
-    DrawTextureRec(screenTexture.texture, { 0, 0, screenSize.x, screenSize.y }, { 0, 0 }, WHITE);
+    if (idle && supersampler.HasImage())
+        DrawTexture(supersampler.GetTexture(), 0, 0, WHITE);
+    else
+        DrawTextureRec(screenTexture.texture, { 0, 0, screenSize.x, screenSize.y }, { 0, 0 }, WHITE);
 
     // Export the fractal to an image if specified.
     if (shouldExportImage)
         ExportToImage();
+    UpdateDeepZoomExport();
+    UpdateImageExport();
+
+    // Free the export rendertextures that haven't been used in a while.
+    renderTexturePool.Update();
 }
 
-void FractalRenderer::StartImageExport()
+bool FractalRenderer::IsAnimated()
 {
-    shouldExportImage = true;
+    return renderJuliaSet && sineParams.y != 0.f;
 }
 
-void FractalRenderer::ExportToImage()
+bool FractalRenderer::IsIdle()
+{
+    return !IsAnimated() && !tilesPending && GetTime() - lastInteractionTime >= interactionDelay;
+}
+
+void FractalRenderer::SetShaderView(const Vector2& viewSize, const float& viewScale, const Vector2& viewOffset)
+{
+    SetShaderValue(fractalShader, GetShaderLocation(fractalShader, "screenSize"), &viewSize,   SHADER_UNIFORM_VEC2);
+    SetShaderValue(fractalShader, GetShaderLocation(fractalShader, "scale"     ), &viewScale,  SHADER_UNIFORM_FLOAT);
+    SetShaderValue(fractalShader, GetShaderLocation(fractalShader, "offset"    ), &viewOffset, SHADER_UNIFORM_VEC2);
+}
+
+std::string FractalRenderer::MakeViewKey()
 {
-    // Draw the current fractal on the export rendertexture.
-    BeginTextureMode(exportTexture);
+    // Everything that changes the pixels of a tile, its position and zoom are given by its level and coordinates.
+    // Floats are written in hexadecimal so that the key is exact. The julia constant is ignored when unused.
+    char viewKey[256];
+    snprintf(viewKey, sizeof(viewKey), "f%d j%d c%a,%a h%a,%a z%d", (int)curFractal, (int)renderJuliaSet,
+             renderJuliaSet ? complexC.x : 0.f, renderJuliaSet ? complexC.y : 0.f, customHue.x, customHue.y, (int)colorPxWithZ);
+    return viewKey;
+}
+
+bool FractalRenderer::RenderTile(const std::string& viewKey, const int& level, const long long& x, const long long& y)
+{
+    RenderTexture tile = tileCache.Add(TileCache::MakeKey(viewKey, level, x, y));
+    if (tile.id == 0) {
+        TraceLog(LOG_WARNING, "Unable to allocate a tile rendertexture.");
+        return false;
+    }
+
+    // Frame the shader on the tile: the tile is its screen and the tile's level is its zoom, which puts the center
+    // of the tile at an offset of (2x+1, 2y+1).
+    const float tileSize = (float)TileCache::tileSize;
+    SetShaderView({ tileSize, tileSize }, (float)ldexp(1.0, level), { (float)(2 * x + 1), (float)(2 * y + 1) });
+    BeginTextureMode(tile);
     {
         ClearBackground(BLACK);
         BeginShaderMode(fractalShader);
         {
-            DrawTextureRec(exportTexture.texture, { 0, 0, 1920 * exportScale, 1080 * exportScale }, { 0, 0 }, WHITE);
+            DrawTextureRec(tile.texture, { 0, 0, tileSize, -tileSize }, { 0, 0 }, WHITE);
         }
         EndShaderMode();
     }
     EndTextureMode();
+    return true;
+}
 
-    // Save the export rendertexture to an image file.
-    Image image = LoadImageFromTexture(exportTexture.texture);
-    const char* filename = "fractal.png";
+void FractalRenderer::ComputeTile(const std::string& viewKey, const int& level, const long long& x, const long long& y, const TaskPriority& priority)
+{
+    // Frame the kernel on the tile like the shader in RenderTile. The view isn't animated, so the time doesn't matter.
+    const int     tileSize = TileCache::tileSize;
+    FractalParams params   = ViewState::GetFractalParams(0.0, tileSize, tileSize);
+    params.scale   = level;
+    params.offsetX = (double)(2 * x + 1);
+    params.offsetY = (double)(2 * y + 1);
+    const ColorParams colorParams = GetColorParams();
+
+    const std::string key        = TileCache::MakeKey(viewKey, level, x, y);
+    const std::string samplesKey = SampleCache::MakeKey(params, tileSize, tileSize, 0, 0, tileSize, tileSize);
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+    tilesInFlight[key] = cancelled;
+    const bool prefetch = priority != TaskPriority::Interactive;
+    threadPool.Submit([this, key, samplesKey, params, colorParams, cancelled, tileSize, prefetch]()
+    {
+        const std::chrono::steady_clock::time_point computeStart = std::chrono::steady_clock::now();
+        ComputedTile computedTile = { key, {}, false, prefetch, 0, 0 };
+        {
+            // The samples are only iterated if the disk cache doesn't have them, the colors aren't part of them.
+            ScopedCharge samplesCharge(&memoryBudget, computeAccount, (size_t)tileSize * tileSize * sizeof(FractalSample));
+            SampleCache::Samples samples = diskCache ? diskCache->Find(samplesKey) : nullptr;
+            if (samples)
+                computedTile.rowsDone = tileSize;
+            else
+            {
+                std::shared_ptr<std::vector<FractalSample>> computed = std::make_shared<std::vector<FractalSample>>((size_t)tileSize * tileSize);
+                FractalKernel kernel(params, tileSize, tileSize);
+                const CancellationToken cancel([cancelled]() { return cancelled->load(); });
+                computedTile.rowsDone = kernel.ComputeRegion(0, 0, tileSize, tileSize, computed->data(), cancel);
+                if (computedTile.rowsDone == tileSize) {
+                    if (diskCache)
+                        diskCache->Insert(samplesKey, computed);
+                    samples = computed;
+                }
+            }
+            if (samples)
+            {
+                computedTile.pixels.resize((size_t)tileSize * tileSize * 4);
+                Colorizer(colorParams).ColorizePixels(samples->data(), tileSize * tileSize, computedTile.pixels.data());
+                computedTile.complete = true;
+            }
+        }
+        computedTile.computeTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - computeStart).count();
+        std::lock_guard<std::mutex> lock(computedTilesMutex);
+        computedTiles.push_back(std::move(computedTile));
+    }, priority);
+}
+
+void FractalRenderer::UploadComputedTiles()
+{
+    std::vector<ComputedTile> uploads;
+    {
+        std::lock_guard<std::mutex> lock(computedTilesMutex);
+        uploads.swap(computedTiles);
+    }
+
+    // Image rows go from top to bottom like the rows of the tile's texture coordinates, so the pixels are uploaded as they are.
+    for (const ComputedTile& computedTile : uploads)
+    {
+        tilesInFlight.erase(computedTile.key);
+        if (!computedTile.complete)
+        {
+            // Tiles cancelled on the way are wasted work, the view's own ones for the rows they had computed.
+            if (computedTile.prefetch) {
+                prefetchWasteCount++;
+                prefetchWastedTime += computedTile.computeTime;
+            }
+            else {
+                cancelledTileCount++;
+                cancelledRowCount += computedTile.rowsDone;
+                cancelledTime     += computedTile.computeTime;
+            }
+            continue;
+        }
+        tileComputeTime += (computedTile.computeTime - tileComputeTime) * 0.1;
+        if (computedTile.prefetch)
+            unshownPrefetches[computedTile.key] = { GetTime(), computedTile.computeTime };
+        RenderTexture tile = tileCache.Add(computedTile.key);
+        if (tile.id == 0) {
+            TraceLog(LOG_WARNING, "Unable to allocate a tile rendertexture.");
+            continue;
+        }
+        UpdateTexture(tile.texture, computedTile.pixels.data());
+    }
+}
+
+void FractalRenderer::UpdateViewVelocity()
+{
+    // The speed is measured on the view itself, so that it follows the mouse, the keys and the ui alike.
+    const double frameTime   = GetFrameTime();
+    const double scaleSquare = pow(2.0, scale);
+    const double centerX     = offset.x / scaleSquare, centerY = offset.y / scaleSquare;
+    if (frameTime > 0)
+    {
+        velocityX    += ((centerX - lastCenterX) / frameTime - velocityX   ) * velocitySmoothing;
+        velocityY    += ((centerY - lastCenterY) / frameTime - velocityY   ) * velocitySmoothing;
+        zoomVelocity += ((scale   - lastScale  ) / frameTime - zoomVelocity) * velocitySmoothing;
+    }
+    lastCenterX = centerX;
+    lastCenterY = centerY;
+    lastScale   = scale;
+}
+
+void FractalRenderer::CancelTileComputations()
+{
+    for (const auto& tileInFlight : tilesInFlight)
+        *tileInFlight.second = true;
+}
+
+bool FractalRenderer::DrawTiles()
+{
+    // At native resolution, the tiles come from the first level with at least as many pixels per unit as the screen,
+    // they are drawn up to two times smaller than their size until the zoom reaches the next level.
+    const double scaleSquare   = pow(2.0, scale);
+    const double pixelsPerUnit = 0.5 * scaleSquare * screenSize.y;
+    const double centerX       = offset.x / scaleSquare, centerY = offset.y / scaleSquare;
+    const int    nativeLevel   = (int)ceil(scale + log2(screenSize.y / TileCache::tileSize));
+    const std::string viewKey  = MakeViewKey();
+    #if !defined(PLATFORM_WEB)
+        UploadComputedTiles();
+    #endif
+
+    // Range of the tiles of a level that are visible in a view (the current one by default), and position of a tile on the screen.
+    struct TileRange { long long minX, minY, maxX, maxY; };
+    auto getTilesAround = [&](const double& viewX, const double& viewY, const double& viewPixelsPerUnit, const int& tileLevel) -> TileRange
+    {
+        const double tileWidth = GetTileWidth(tileLevel);
+        return { (long long)floor((viewX - screenSize.x / 2 / viewPixelsPerUnit) / tileWidth),
+                 (long long)floor((viewY - screenSize.y / 2 / viewPixelsPerUnit) / tileWidth),
+                 (long long)floor((viewX + screenSize.x / 2 / viewPixelsPerUnit) / tileWidth),
+                 (long long)floor((viewY + screenSize.y / 2 / viewPixelsPerUnit) / tileWidth) };
+    };
+    auto getVisibleTiles = [&](const int& tileLevel) -> TileRange
+    {
+        return getTilesAround(centerX, centerY, pixelsPerUnit, tileLevel);
+    };
+    auto getScreenRect = [&](const int& tileLevel, const long long& x, const long long& y) -> Rectangle
+    {
+        // Both edges are computed the same way for all tiles, so that neighbours meet without gaps.
+        const double tileWidth = GetTileWidth(tileLevel);
+        const float  left   = (float)((x       * tileWidth - centerX) * pixelsPerUnit + screenSize.x / 2);
+        const float  top    = (float)((y       * tileWidth - centerY) * pixelsPerUnit + screenSize.y / 2);
+        const float  right  = (float)(((x + 1) * tileWidth - centerX) * pixelsPerUnit + screenSize.x / 2);
+        const float  bottom = (float)(((y + 1) * tileWidth - centerY) * pixelsPerUnit + screenSize.y / 2);
+        return { left, top, right - left, bottom - top };
+    };
+    auto countMissingTiles = [&](const int& tileLevel) -> int
+    {
+        const TileRange range = getVisibleTiles(tileLevel);
+        int missingTileCount = 0;
+        for (long long y = range.minY; y <= range.maxY; y++)
+            for (long long x = range.minX; x <= range.maxX; x++)
+                if (!tileCache.Find(TileCache::MakeKey(viewKey, tileLevel, x, y)))
+                    missingTileCount++;
+        return missingTileCount;
+    };
+
+    // Number of tiles that can be made within the target frame time. The workers' speed is measured on the tiles they
+    // compute. On the web, the number of tiles rendered each frame goes down when frames take too long, and up otherwise.
+    #if defined(PLATFORM_WEB)
+        if (tilesRenderedLastFrame > 0)
+        {
+            if (GetFrameTime() > targetFrameTime * frameTimeTolerance)
+                tileRendersPerFrame = std::max(1, tileRendersPerFrame * 3 / 4);
+            else
+                tileRendersPerFrame = std::min(maxTileRendersPerFrame, tileRendersPerFrame + 1);
+        }
+        const double tilesPerFrame = tileRendersPerFrame;
+    #else
+        const double tilesPerFrame = targetFrameTime / tileComputeTime * threadPool.GetThreadCount();
+    #endif
+
+    // While the view changes, draw it from a coarser level if the native one can't be ready in time, down to an eighth
+    // of the native resolution. The native level is filled in once the view stops changing.
+    resolutionDrop = 0;
+    if (GetTime() - lastInteractionTime < interactionDelay)
+        while (resolutionDrop < maxResolutionDrop && countMissingTiles(nativeLevel - resolutionDrop) > tilesPerFrame)
+            resolutionDrop++;
+    const int level = nativeLevel - resolutionDrop;
+
+    // Find the missing tiles from the center of the screen outwards, and the coarse ones while some are missing.
+    struct MissingTile { int level; long long x, y; double distance; };
+    std::vector<MissingTile> missingTiles;
+    for (const int& tileLevel : { level, level - coarseLevelOffset })
+    {
+        if (tileLevel != level && missingTiles.empty()) break;
+        const TileRange range     = getVisibleTiles(tileLevel);
+        const double    tileWidth = GetTileWidth(tileLevel);
+        const size_t    firstTile = missingTiles.size();
+        for (long long y = range.minY; y <= range.maxY; y++)
+        {
+            for (long long x = range.minX; x <= range.maxX; x++)
+            {
+                if (tileCache.Find(TileCache::MakeKey(viewKey, tileLevel, x, y))) continue;
+                const double distanceX = (x + 0.5) * tileWidth - centerX, distanceY = (y + 0.5) * tileWidth - centerY;
+                missingTiles.push_back({ tileLevel, x, y, distanceX * distanceX + distanceY * distanceY });
+            }
+        }
+        std::sort(missingTiles.begin() + firstTile, missingTiles.end(),
+                  [](const MissingTile& a, const MissingTile& b) { return a.distance < b.distance; });
+
+        // The coarse tiles go first, so that the whole view quickly has something to show.
+        if (tileLevel != level)
+            std::rotate(missingTiles.begin(), missingTiles.begin() + firstTile, missingTiles.end());
+    }
+
+    // Prefetch the tiles of where the view will be in a moment if it keeps moving at the same speed.
+    std::vector<MissingTile> prefetchTiles;
+    const double predictedX     = centerX + velocityX * prefetchTime, predictedY = centerY + velocityY * prefetchTime;
+    const double predictedScale = scale + zoomVelocity * prefetchTime;
+    const double movedPixels    = hypot(predictedX - centerX, predictedY - centerY) * pixelsPerUnit;
+    if (movedPixels > minPrefetchPixels || fabs(predictedScale - scale) > minPrefetchZoom)
+    {
+        const double predictedPixelsPerUnit = 0.5 * pow(2.0, predictedScale) * screenSize.y;
+        const int    predictedLevel = (int)ceil(predictedScale + log2(screenSize.y / TileCache::tileSize)) - resolutionDrop;
+        const TileRange visibleRange   = getVisibleTiles(predictedLevel);
+        const TileRange predictedRange = getTilesAround(predictedX, predictedY, predictedPixelsPerUnit, predictedLevel);
+        for (long long y = predictedRange.minY; y <= predictedRange.maxY && (int)prefetchTiles.size() < maxPrefetchTiles; y++)
+        {
+            for (long long x = predictedRange.minX; x <= predictedRange.maxX && (int)prefetchTiles.size() < maxPrefetchTiles; x++)
+            {
+                // The tiles that are visible already are requested as missing tiles.
+                const bool visible = predictedLevel == level && x >= visibleRange.minX && x <= visibleRange.maxX && y >= visibleRange.minY && y <= visibleRange.maxY;
+                if (visible || tileCache.Find(TileCache::MakeKey(viewKey, predictedLevel, x, y))) continue;
+                prefetchTiles.push_back({ predictedLevel, x, y, 0 });
+            }
+        }
+    }
+
+    // Prefetched tiles that still haven't been shown a while after they were made were wasted.
+    for (auto unshown = unshownPrefetches.begin(); unshown != unshownPrefetches.end(); )
+    {
+        if (GetTime() - unshown->second.doneTime > prefetchExpiry) {
+            prefetchWasteCount++;
+            prefetchWastedTime += unshown->second.computeTime;
+            unshown = unshownPrefetches.erase(unshown);
+        }
+        else {
+            unshown++;
+        }
+    }
 
     #if defined(PLATFORM_WEB)
-        int dataSize = 0;
-        unsigned char* fileData = stbi_write_png_to_mem((const unsigned char*)image.data, image.width*4, image.width, image.height, 4, &dataSize);
-        EM_ASM_({ window.download($0, $1, $2) }, filename, fileData, dataSize);
-        RL_FREE(fileData);
+        // Without threads, the shader renders as many as the frame allows, the others are rendered in the next frames.
+        int renderedTiles = 0;
+        while (renderedTiles < (int)missingTiles.size() && renderedTiles < tileRendersPerFrame)
+        {
+            const MissingTile& missingTile = missingTiles[renderedTiles];
+            if (!RenderTile(viewKey, missingTile.level, missingTile.x, missingTile.y)) break;
+            renderedTiles++;
+        }
+        const bool allTilesDrawn = renderedTiles == (int)missingTiles.size();
+        tilesRenderedLastFrame   = renderedTiles;
+
+        // The rest of the frame's tiles go to the prefetched ones.
+        for (size_t i = 0; allTilesDrawn && i < prefetchTiles.size() && tilesRenderedLastFrame < tileRendersPerFrame; i++)
+        {
+            const MissingTile& prefetchTile = prefetchTiles[i];
+            if (!RenderTile(viewKey, prefetchTile.level, prefetchTile.x, prefetchTile.y)) break;
+            unshownPrefetches[TileCache::MakeKey(viewKey, prefetchTile.level, prefetchTile.x, prefetchTile.y)] = { GetTime(), 0 };
+            tilesRenderedLastFrame++;
+        }
+        if (tilesRenderedLastFrame > 0)
+            SetShaderView(screenSize, (float)scaleSquare, { offset.x, offset.y });
     #else
-        ExportImage(image, filename);
+        // The workers compute the tiles in the queue order, so that the frame never waits for them, the prefetched ones
+        // after the missing ones. The tiles being computed that aren't wanted anymore are cancelled, and the cancelled
+        // ones that are wanted again resumed.
+        std::unordered_map<std::string, bool> wantedTiles;
+        auto requestTiles = [&](const std::vector<MissingTile>& tiles, const TaskPriority& priority)
+        {
+            for (const MissingTile& tile : tiles)
+            {
+                const std::string key = TileCache::MakeKey(viewKey, tile.level, tile.x, tile.y);
+                wantedTiles[key] = true;
+                auto inFlight = tilesInFlight.find(key);
+                if (inFlight == tilesInFlight.end())
+                    ComputeTile(viewKey, tile.level, tile.x, tile.y, priority);
+                else
+                    *inFlight->second = false;
+            }
+        };
+        requestTiles(missingTiles,  TaskPriority::Interactive);
+        requestTiles(prefetchTiles, TaskPriority::Prefetch);
+        for (const auto& tileInFlight : tilesInFlight)
+            if (!wantedTiles.count(tileInFlight.first))
+                *tileInFlight.second = true;
+        const bool allTilesDrawn = missingTiles.empty();
     #endif
 
-    UnloadImage(image);
+    // Draw the tiles onto the screen rendertexture. Until they are all there, the last complete frame is drawn under
+    // them, moved and scaled to the current view, so that zooming and panning show something at once. Without a
+    // complete frame, the parts of the screen without any tile keep the previous frame.
+    const TileRange range = getVisibleTiles(level);
+    BeginTextureMode(screenTexture);
+    {
+        if (!allTilesDrawn && lastCompleteFrame.valid)
+        {
+            const double frameScale = pixelsPerUnit / lastCompleteFrame.pixelsPerUnit;
+            const float  left       = (float)((lastCompleteFrame.centerX - centerX) * pixelsPerUnit + screenSize.x / 2 * (1 - frameScale));
+            const float  top        = (float)((lastCompleteFrame.centerY - centerY) * pixelsPerUnit + screenSize.y / 2 * (1 - frameScale));
+            ClearBackground(BLACK);
+            DrawViewTexture(lastCompleteFrame.renderTexture, { 0, 0, screenSize.x, screenSize.y },
+                            { left, top, (float)(screenSize.x * frameScale), (float)(screenSize.y * frameScale) });
+        }
+        for (long long y = range.minY; y <= range.maxY; y++)
+        {
+            for (long long x = range.minX; x <= range.maxX; x++)
+            {
+                const Rectangle      screenRect = getScreenRect(level, x, y);
+                const std::string    key        = TileCache::MakeKey(viewKey, level, x, y);
+                const RenderTexture* tile       = tileCache.Find(key);
+                if (tile && unshownPrefetches.erase(key))
+                    prefetchHitCount++;
+                if (tile)
+                    DrawViewTexture(*tile, { 0, 0, (float)TileCache::tileSize, (float)TileCache::tileSize }, screenRect);
+                else
+                    DrawTileFallback(viewKey, level, x, y, screenRect);
+            }
+        }
+    }
+    EndTextureMode();
+
+    // Keep the frame once it is complete.
+    if (allTilesDrawn)
+    {
+        BeginTextureMode(lastCompleteFrame.renderTexture);
+        {
+            DrawViewTexture(screenTexture, { 0, 0, screenSize.x, screenSize.y }, { 0, 0, screenSize.x, screenSize.y });
+        }
+        EndTextureMode();
+        lastCompleteFrame = { lastCompleteFrame.renderTexture, true, centerX, centerY, pixelsPerUnit };
+    }
+    return allTilesDrawn && resolutionDrop == 0;
+}
+
+void FractalRenderer::DrawTileFallback(const std::string& viewKey, const int& level, const long long& x, const long long& y, const Rectangle& screenRect)
+{
+    // Draw the part of the closest coarser tile that covers the missing one, upscaled.
+    for (int levelsUp = 1; levelsUp <= maxFallbackLevels; levelsUp++)
+    {
+        // Shifting rounds negative coordinates down too.
+        const long long parentX = x >> levelsUp, parentY = y >> levelsUp, childCount = 1LL << levelsUp;
+        const RenderTexture* parent = tileCache.Find(TileCache::MakeKey(viewKey, level - levelsUp, parentX, parentY));
+        if (!parent) continue;
+
+        const float cellSize = (float)TileCache::tileSize / childCount;
+        DrawViewTexture(*parent, { (x - parentX * childCount) * cellSize, (y - parentY * childCount) * cellSize, cellSize, cellSize }, screenRect);
+        return;
+    }
+
+    // Otherwise draw the finer tiles that are there, which happens when zooming out.
+    for (int child = 0; child < 4; child++)
+    {
+        const RenderTexture* childTile = tileCache.Find(TileCache::MakeKey(viewKey, level + 1, x * 2 + child % 2, y * 2 + child / 2));
+        if (!childTile) continue;
+
+        const float halfWidth = screenRect.width / 2, halfHeight = screenRect.height / 2;
+        DrawViewTexture(*childTile, { 0, 0, (float)TileCache::tileSize, (float)TileCache::tileSize },
+                       { screenRect.x + (child % 2) * halfWidth, screenRect.y + (child / 2) * halfHeight, halfWidth, halfHeight });
+    }
+}
+
+void FractalRenderer::DrawViewTexture(const RenderTexture& texture, const Rectangle& sourceRect, const Rectangle& screenRect)
+{
+    // The tiles and the frames hold the view with its top row first in texture coordinates. Rendertextures are stored
+    // upside down, so the region is drawn flipped onto the screen-sized rendertextures, which are flipped back when shown.
+    DrawTexturePro(texture.texture, { sourceRect.x, sourceRect.y, sourceRect.width, -sourceRect.height },
+                   { screenRect.x, screenSize.y - screenRect.y - screenRect.height, screenRect.width, screenRect.height }, { 0, 0 }, 0, WHITE);
+}
+
+void FractalRenderer::StartImageExport()
+{
+    shouldExportImage = true;
+    resumeExport      = false;
+}
+
+void FractalRenderer::ResumeDeepZoomExport()
+{
+    exportFormat      = ExportFormats::DeepZoom;
+    shouldExportImage = true;
+    resumeExport      = true;
+}
+
+void FractalRenderer::ExportToImage()
+{
+    // On desktop, the view is drawn from tiles computed on the cpu and its pngs are computed the same way. The web draws
+    // them with the shader, and so its pngs.
+    #if defined(PLATFORM_WEB)
+        const bool cpuImage = exportFormat == ExportFormats::RawFloat;
+    #else
+        const bool cpuImage = exportFormat == ExportFormats::RawFloat || exportFormat == ExportFormats::Png;
+    #endif
+    if (cpuImage) {
+        ExportCpuImage();
+        shouldExportImage = false;
+        return;
+    }
+    if (exportFormat == ExportFormats::DeepZoom) {
+        ExportDeepZoom();
+        shouldExportImage = false;
+        return;
+    }
+
+    // The image is drawn in bands of rows, as tall as the memory budget allows (the whole image if it fits), so that
+    // large exports don't need a rendertexture of the whole image.
+    const int    exportWidth = (int)(1920 * exportScale), exportHeight = (int)(1080 * exportScale);
+    const size_t rowBytes    = RenderTexturePool::GetByteSize(exportWidth, 1);
+    const size_t roomRows    = memoryBudget.MakeRoom(rowBytes * exportHeight) / rowBytes;
+    const int    bandRows    = std::max(std::min((int)roomRows, exportHeight), std::min(minExportBandRows, exportHeight));
+    RenderTexture exportTexture = renderTexturePool.Acquire(exportWidth, bandRows);
+    if (exportTexture.id == 0) {
+        TraceLog(LOG_WARNING, "Unable to allocate a %dx%d export rendertexture.", exportWidth, bandRows);
+        shouldExportImage = false;
+        return;
+    }
+
+    // Each band is read back in blocks of rows, and each block is encoded while the next ones are being copied.
+    const char* filename = "fractal.png";
+    PngWriter png(exportWidth, exportHeight);
+    #if defined(PLATFORM_WEB)
+        png.OpenInMemory();
+    #else
+        if (!png.Open(filename)) {
+            TraceLog(LOG_WARNING, "Unable to open %s for writing.", filename);
+            renderTexturePool.Release(exportTexture);
+            shouldExportImage = false;
+            return;
+        }
+    #endif
+
+    PixelReadback readback(exportTexture);
+    ScopedCharge  readbackCharge(&memoryBudget, exportAccount, readback.GetBufferBytes());
+    for (int firstRow = 0; firstRow < exportHeight; firstRow += bandRows)
+    {
+        // Draw the rows of the band. The texture coordinates go over the band's part of the whole image, which is how
+        // the shader knows where the band is.
+        BeginTextureMode(exportTexture);
+        {
+            ClearBackground(BLACK);
+            BeginShaderMode(fractalShader);
+            {
+                const float bandScale = (float)bandRows / exportHeight;
+                DrawTexturePro(exportTexture.texture, { 0, firstRow * bandScale, (float)exportWidth, bandRows * bandScale },
+                               { 0, 0, (float)exportWidth, (float)bandRows }, { 0, 0 }, 0, WHITE);
+            }
+            EndShaderMode();
+        }
+        EndTextureMode();
+
+        // The last band can go past the bottom of the image, its extra rows are dropped.
+        int remainingRows = std::min(bandRows, exportHeight - firstRow);
+        readback.ReadAll([&](const unsigned char* rows, const int& rowCount, const int& rowStride)
+        {
+            const int usedRows = std::min(rowCount, remainingRows);
+            if (usedRows > 0)
+                png.WriteRows(rows, usedRows, rowStride);
+            remainingRows -= usedRows;
+        });
+    }
+
+    if (!png.Close())
+        TraceLog(LOG_WARNING, "Failed to export %s.", filename);
+    #if defined(PLATFORM_WEB)
+        else
+            EM_ASM_({ window.download($0, $1, $2) }, filename, png.GetData().data(), (int)png.GetData().size());
+    #endif
+
+    renderTexturePool.Release(exportTexture);
     shouldExportImage = false;
 }
 
+void FractalRenderer::ExportCpuImage()
+{
+    if (imageJob)
+        return;
+
+    // Raw iteration data can't be read back from 8 bit rendertextures, and pngs are computed with the precision of the
+    // view, so both are computed on the cpu.
+    const int exportWidth = (int)(1920 * exportScale), exportHeight = (int)(1080 * exportScale);
+    std::unique_ptr<ImageJob> job = std::make_unique<ImageJob>();
+    if (exportFormat == ExportFormats::Png) {
+        job->png      = std::make_unique<PngWriter>(exportWidth, exportHeight);
+        job->filename = "fractal.png";
+    }
+    else {
+        job->exr      = std::make_unique<ExrWriter>(exportWidth, exportHeight, std::vector<std::string>{ "iterations", "smooth", "z.re", "z.im" },
+                                                    compressRawExport ? ExrCompression::Zip : ExrCompression::None);
+        job->filename = "fractal.exr";
+    }
+    job->params      = GetFractalParams();
+    job->colorParams = GetColorParams();
+    job->width       = exportWidth;
+    job->height      = exportHeight;
+
+    // The web has no threads and only exports raw data this way, which is written at once and downloaded.
+    #if defined(PLATFORM_WEB)
+        job->exr->OpenInMemory();
+        WriteRawData(*job);
+        const std::vector<unsigned char>& data = job->exr->GetData();
+        if (!job->succeeded)
+            TraceLog(LOG_WARNING, "Failed to export %s.", job->filename);
+        else
+            EM_ASM_({ window.download($0, $1, $2) }, job->filename, data.data(), (int)data.size());
+    #else
+        if (!(job->png ? job->png->Open(job->filename) : job->exr->Open(job->filename))) {
+            TraceLog(LOG_WARNING, "Unable to open %s for writing.", job->filename);
+            return;
+        }
+        ImageJob* running = job.get();
+        job->thread = std::thread([this, running]() {
+            if (running->png)
+                WritePng(*running);
+            else
+                WriteRawData(*running);
+            running->done = true;
+        });
+        imageJob = std::move(job);
+    #endif
+}
+
+void FractalRenderer::WritePng(ImageJob& job)
+{
+    // Compute and colorize a batch of blocks of rows in parallel, then encode them in order. Only one batch is ever in memory.
+    PngWriter&    png = *job.png;
+    FractalKernel kernel(job.params, job.width, job.height);
+    const CancellationToken cancel([&job]() { return job.cancelled.load(); });
+    const int    blockRows = 16, batchRows = threadPool.GetThreadCount() * 2 * blockRows;
+    std::vector<unsigned char> batch((size_t)batchRows * job.width * 4);
+    ScopedCharge batchCharge(&memoryBudget, exportAccount, batch.size());
+    for (int firstRow = 0; firstRow < job.height && !job.cancelled; firstRow += batchRows)
+    {
+        const int rowCount = std::min(batchRows, job.height - firstRow);
+        threadPool.ParallelFor((rowCount + blockRows - 1) / blockRows, [&](int i)
+        {
+            const int firstLine = firstRow + i * blockRows;
+            const int lineCount = std::min(blockRows, firstRow + rowCount - firstLine);
+            ScopedCharge samplesCharge(&memoryBudget, exportAccount, (size_t)lineCount * job.width * sizeof(FractalSample));
+            std::vector<FractalSample> samples((size_t)lineCount * job.width);
+            if (kernel.ComputeRows(firstLine, lineCount, samples.data(), cancel) == lineCount)
+                Colorizer(job.colorParams).ColorizePixels(samples.data(), lineCount * job.width, &batch[(size_t)i * blockRows * job.width * 4]);
+        }, TaskPriority::Export);
+        if (job.cancelled)
+            break;
+        png.WriteRows(batch.data(), rowCount, job.width * 4);
+        job.rowsWritten += rowCount;
+    }
+
+    // A cancelled export has rows missing, which makes it fail.
+    job.succeeded = png.Close();
+}
+
+void FractalRenderer::WriteRawData(ImageJob& job)
+{
+    // Compute and encode a batch of blocks in parallel, then write them in order. Only one batch is ever in memory.
+    static_assert(sizeof(FractalSample) == 4 * sizeof(float), "FractalSample must be made of the 4 exported channels.");
+    ExrWriter&    exr = *job.exr;
+    FractalKernel kernel(job.params, job.width, job.height);
+    const CancellationToken cancel([&job]() { return job.cancelled.load(); });
+    const int    batchSize  = threadPool.GetThreadCount() * 2;
+    const size_t blockBytes = (size_t)exr.GetLinesPerBlock() * job.width * sizeof(FractalSample);
+    std::vector<std::vector<unsigned char>> encodedBlocks(batchSize);
+    ScopedCharge encodedCharge(&memoryBudget, exportAccount, batchSize * blockBytes); // The encoded blocks are charged at their raw size, which compressed ones hardly exceed.
+    for (int firstBlock = 0; firstBlock < exr.GetBlockCount() && !job.cancelled; firstBlock += batchSize)
+    {
+        const int blockCount = std::min(batchSize, exr.GetBlockCount() - firstBlock);
+        threadPool.ParallelFor(blockCount, [&](int i)
+        {
+            const int firstLine = (firstBlock + i) * exr.GetLinesPerBlock();
+            const int lineCount = std::min(exr.GetLinesPerBlock(), job.height - firstLine);
+            ScopedCharge samplesCharge(&memoryBudget, exportAccount, (size_t)lineCount * job.width * sizeof(FractalSample));
+            std::vector<FractalSample> samples((size_t)lineCount * job.width);
+            if (kernel.ComputeRows(firstLine, lineCount, samples.data(), cancel) == lineCount)
+                exr.EncodeBlock(firstBlock + i, &samples[0].iterations, encodedBlocks[i]);
+        }, TaskPriority::Export);
+        if (job.cancelled)
+            break;
+        for (int i = 0; i < blockCount; i++)
+            exr.WriteBlock(encodedBlocks[i]);
+        job.rowsWritten = std::min((firstBlock + blockCount) * exr.GetLinesPerBlock(), job.height);
+    }
+
+    // A cancelled export has blocks missing, which makes it fail.
+    job.succeeded = exr.Close();
+}
+
+void FractalRenderer::UpdateImageExport()
+{
+    if (!imageJob || !imageJob->done)
+        return;
+
+    // The incomplete file of a cancelled export is removed.
+    imageJob->thread.join();
+    if (imageJob->cancelled)
+        std::remove(imageJob->filename);
+    else if (!imageJob->succeeded)
+        TraceLog(LOG_WARNING, "Failed to export %s.", imageJob->filename);
+    imageJob.reset();
+}
+
+void FractalRenderer::ExportDeepZoom()
+{
+    if (deepZoomJob)
+        return;
+
+    // The tiles are rendered on the cpu so that the image size isn't limited by the maximum texture size.
+    const int exportWidth = (int)(1920 * exportScale), exportHeight = (int)(1080 * exportScale);
+    std::unique_ptr<DeepZoomJob> job = std::make_unique<DeepZoomJob>();
+    job->exporter = std::make_unique<DeepZoomExporter>(GetFractalParams(), GetColorParams(), exportWidth, exportHeight, threadPool);
+
+    // The samples are kept on disk so that exporting the same view again (with other colors for example) is quick.
+    job->exporter->diskCache = diskCache.get();
+
+    // When resuming, the parameters of the interrupted export replace the current ones.
+    const bool resuming = resumeExport;
+    resumeExport = false;
+    if (resuming && !job->exporter->LoadCheckpoint("fractal")) {
+        TraceLog(LOG_WARNING, "Unable to resume the export, fractal.checkpoint is invalid.");
+        return;
+    }
+
+    // The export thread only waits for its tiles, which the workers render along with the view's at a lower priority.
+    DeepZoomJob* running = job.get();
+    job->thread = std::thread([running]() {
+        running->succeeded = running->exporter->Export("fractal");
+        running->done      = true;
+    });
+    deepZoomJob = std::move(job);
+}
+
+void FractalRenderer::UpdateDeepZoomExport()
+{
+    if (!deepZoomJob || !deepZoomJob->done)
+        return;
+
+    // A cancelled export isn't a failure as long as it can be resumed.
+    deepZoomJob->thread.join();
+    exportCheckpointExists = DeepZoomExporter::HasCheckpoint("fractal");
+    if (!deepZoomJob->succeeded && !(deepZoomJob->exporter->IsCancelled() && exportCheckpointExists))
+        TraceLog(LOG_WARNING, "Failed to export fractal.dzi.");
+    deepZoomJob.reset();
+}
+
+void FractalRenderer::CancelExport()
+{
+    if (deepZoomJob)
+        deepZoomJob->exporter->Cancel();
+    if (imageJob)
+        imageJob->cancelled = true;
+}
+
+float FractalRenderer::GetExportProgress()
+{
+    if (deepZoomJob)
+        return (float)deepZoomJob->exporter->GetTileRowsRendered() / deepZoomJob->exporter->GetTileRowCount();
+    if (imageJob)
+        return (float)imageJob->rowsWritten / imageJob->height;
+    return 0;
+}
+
+FractalParams FractalRenderer::GetFractalParams()
+{
+    return ViewState::GetFractalParams(GetTimeSinceStart(), screenSize.x, screenSize.y);
+}
+
+std::string FractalRenderer::MakeHistoryKey()
+{
+    char position[128];
+    snprintf(position, sizeof(position), " | o%a,%a s%a", offset.x, offset.y, scale);
+    return MakeViewKey() + position;
+}
+
+void FractalRenderer::RecordHistory()
+{
+    // A view that is already the current one only needs a snapshot if it has none, and none is on its way.
+    const std::string key = MakeHistoryKey();
+    if (!history.Push(*this, key) && (history.HasSnapshot() || history.IsSnapshotPending() || (snapshotRead.pending && snapshotRead.historyKey == key)))
+        return;
+
+    // The view is complete, so the last complete frame is its frame. It is copied to a pixel buffer now and collected
+    // by a later frame, so that this one doesn't wait for the gpu. The read of an older view is dropped.
+    historyReadback->CancelReads();
+    if (!historyReadback->StartRead(0)) {
+        snapshotRead.pending = false;
+        TraceLog(LOG_WARNING, "Unable to read the frame of the view back for the history.");
+        return;
+    }
+    snapshotRead = { true, key, lastCompleteFrame.centerX, lastCompleteFrame.centerY, lastCompleteFrame.pixelsPerUnit };
+}
+
+void FractalRenderer::CollectSnapshot()
+{
+    if (!snapshotRead.pending)
+        return;
+
+    historyReadback->CollectReads([&](const int& tag, const unsigned char* firstRow, const int& rowCount, const int& rowStride)
+    {
+        // The snapshots are kept in the row order of the texture, which is the one UpdateTexture expects.
+        snapshotRead.pending = false;
+        if (!history.IsCurrent(snapshotRead.historyKey))
+            return;
+        const unsigned char* bottomRow = firstRow + (ptrdiff_t)(rowCount - 1) * rowStride;
+        std::vector<unsigned char> pixels(bottomRow, bottomRow + (size_t)rowCount * -rowStride);
+        history.StoreSnapshot(std::move(pixels), -rowStride / 4, rowCount, snapshotRead.centerX, snapshotRead.centerY, snapshotRead.pixelsPerUnit);
+    });
+}
+
+void FractalRenderer::RestoreView(const ViewState& view)
+{
+    static_cast<ViewState&>(*this) = view;
+    SendDataToShader();
+    ValueModifiedThisFrame(ModifiableValues::CurFractal);
+
+    // Show the snapshot of the view under its tiles until they are all there, the cached ones are drawn over it at
+    // once and the others are computed again.
+    std::shared_ptr<const ViewHistory::Snapshot> snapshot = history.FindSnapshot();
+    if (!snapshot || snapshot->width != lastCompleteFrame.renderTexture.texture.width || snapshot->height != lastCompleteFrame.renderTexture.texture.height)
+        return;
+    int size = 0;
+    unsigned char* pixels = DecompressData(snapshot->data.data(), (int)snapshot->data.size(), &size);
+    if (pixels && size == snapshot->width * snapshot->height * 4) {
+        UpdateTexture(lastCompleteFrame.renderTexture.texture, pixels);
+        lastCompleteFrame = { lastCompleteFrame.renderTexture, true, snapshot->centerX, snapshot->centerY, snapshot->pixelsPerUnit };
+    }
+    MemFree(pixels);
+}
+
+void FractalRenderer::Undo()
+{
+    // The view is only recorded once it is still, so a view that was left before that isn't in the history. Undoing
+    // then goes back to the last recorded view rather than to the one before it.
+    const ViewState* current = history.GetCurrent();
+    if (current && !history.IsCurrent(MakeHistoryKey())) {
+        RestoreView(*current);
+        return;
+    }
+    if (const ViewState* view = history.Undo())
+        RestoreView(*view);
+}
+
+void FractalRenderer::Redo()
+{
+    if (const ViewState* view = history.Redo())
+        RestoreView(*view);
+}
+
+Float2 FractalRenderer::GetViewPoint(const Vector2& screenPosition)
+{
+    const double zoom = pow(2.0, scale);
+    return { (float)((screenPosition.x - screenSize.x / 2) / (0.5 * zoom * screenSize.y) + offset.x / zoom),
+             (float)((screenPosition.y - screenSize.y / 2) / (0.5 * zoom * screenSize.y) + offset.y / zoom) };
+}
+
 void FractalRenderer::SetExportScale(const float& _exportScale)
 {
-    UnloadRenderTexture(exportTexture);
-    exportScale   = _exportScale;
-    exportTexture = LoadRenderTexture((int)(1920 * exportScale), (int)(1080 * exportScale));
+    exportScale = _exportScale;
 }
 
 void FractalRenderer::ValueModifiedThisFrame(const ModifiableValues& modifiedValue)
@@ -200,5 +1127,10 @@ void FractalRenderer::ValueModifiedThisFrame(const ModifiableValues& modifiedVal
             break;
         }
     }
+    if (modifiedValue != ModifiableValues::Scale && modifiedValue != ModifiableValues::Offset)
+        minimapOutdated = true;
+    historyOutdated = true;
     valueModifiedThisFrame = true;
+    lastInteractionTime    = GetTime();
+    supersampler.Restart();
 }
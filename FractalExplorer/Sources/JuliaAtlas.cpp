@@ -0,0 +1,157 @@
+#include "JuliaAtlas.h"
+#include <algorithm>
+#include <cstdio>
+
+const int JuliaAtlas::columns;
+const int JuliaAtlas::thumbnailSize;
+
+// Rows of each task of a grid.
+static const int bandRows = 8;
+
+// Time spent on the grid each frame on the web, where there are no workers.
+static const std::chrono::microseconds webSliceTime(3000);
+
+JuliaAtlas::Grid::Grid(const FractalParams& _params, const ColorParams& _colorParams, const double& _centerX, const double& _centerY, const double& _spacing, const std::string& _key)
+    : params(_params), colorParams(_colorParams), centerX(_centerX), centerY(_centerY), spacing(_spacing), key(_key),
+      pixels((size_t)columns * thumbnailSize * columns * thumbnailSize * 4, 255), bandsLeft(0), cancelled(false)
+{
+}
+
+JuliaAtlas::JuliaAtlas(ThreadPool& _threadPool)
+    : threadPool(_threadPool)
+{
+}
+
+JuliaAtlas::~JuliaAtlas()
+{
+    Unload();
+}
+
+void JuliaAtlas::Unload()
+{
+    if (grid)
+        grid->cancelled = true;
+    grid.reset();
+    shownKey.clear();
+    if (texture.id != 0) {
+        UnloadTexture(texture);
+        texture = {};
+    }
+}
+
+void JuliaAtlas::Update(const FractalTypes& fractal, const ColorParams& colorParams, const double& centerX, const double& centerY)
+{
+    // Let the grid being computed finish rather than restarting it, so that something is shown while the center moves.
+    if (grid)
+    {
+        #if defined(PLATFORM_WEB)
+            // Without workers, iterate the pixels for a slice of each frame, with the kernel of their thumbnail. The
+            // pixel being iterated when the slice runs out is resumed the next frame.
+            const int size = columns * thumbnailSize;
+            std::vector<FractalKernel> kernels;
+            for (int thumbnail = 0; thumbnail < columns * columns; thumbnail++)
+            {
+                FractalParams params  = grid->params;
+                const Float2  complex = GetThumbnailC(grid->centerX, grid->centerY, grid->spacing, thumbnail % columns, thumbnail / columns);
+                params.complexCX = complex.x;
+                params.complexCY = complex.y;
+                kernels.emplace_back(params, thumbnailSize, thumbnailSize);
+            }
+            Colorizer colorizer(grid->colorParams);
+            const bool gridDone = grid->slicer.Run(IterationSlicer::Clock::now() + webSliceTime,
+                [&](const int& pixel, double& x, double& y) -> FractalKernel& {
+                    x = pixel % size % thumbnailSize + 0.5;
+                    y = pixel / size % thumbnailSize + 0.5;
+                    return kernels[pixel / size / thumbnailSize * columns + pixel % size / thumbnailSize];
+                },
+                [&](const int& pixel, const FractalSample& sample) {
+                    colorizer.ColorizePixel(sample, &grid->pixels[(size_t)pixel * 4]);
+                });
+            if (gridDone)
+                grid->bandsLeft = 0;
+        #endif
+        if (grid->bandsLeft > 0)
+            return;
+        ShowGrid();
+    }
+
+    // Start the grid of the latest center if it isn't the one shown.
+    char key[160];
+    snprintf(key, sizeof(key), "f%d c%a,%a s%a h%a,%a z%d", (int)fractal, centerX, centerY, (double)spacing,
+             colorParams.hueFg, colorParams.hueBg, (int)colorParams.colorWithZ);
+    if (shownKey == key)
+        return;
+
+    FractalParams params;
+    params.fractal    = fractal;
+    params.juliaSet   = true;
+    params.scale      = -1;
+    params.viewWidth  = thumbnailSize;
+    params.viewHeight = thumbnailSize;
+    grid = std::make_shared<Grid>(params, colorParams, centerX, centerY, (double)spacing, key);
+    StartGrid();
+}
+
+void JuliaAtlas::StartGrid()
+{
+    const int bandCount = (columns * thumbnailSize + bandRows - 1) / bandRows;
+    grid->bandsLeft = bandCount;
+    #if defined(PLATFORM_WEB)
+        grid->slicer.Restart(columns * thumbnailSize * columns * thumbnailSize);
+    #else
+        // The user is waiting for the grid, like for the tiles of the view.
+        std::shared_ptr<Grid> job = grid;
+        for (int band = 0; band < bandCount; band++)
+            threadPool.Submit([job, band]() { ComputeBand(*job, band); }, TaskPriority::Interactive);
+    #endif
+}
+
+void JuliaAtlas::ShowGrid()
+{
+    const int size = columns * thumbnailSize;
+    if (texture.id == 0)
+    {
+        Image image = { grid->pixels.data(), size, size, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        texture = LoadTextureFromImage(image);
+    }
+    else
+    {
+        UpdateTexture(texture, grid->pixels.data());
+    }
+    shownKey     = grid->key;
+    shownCenterX = grid->centerX;
+    shownCenterY = grid->centerY;
+    shownSpacing = grid->spacing;
+    grid.reset();
+}
+
+void JuliaAtlas::ComputeBand(Grid& grid, const int& band)
+{
+    const int size   = columns * thumbnailSize;
+    const int endRow = std::min(size, (band + 1) * bandRows);
+
+    Colorizer colorizer(grid.colorParams);
+    for (int y = band * bandRows; y < endRow && !grid.cancelled; y++)
+    {
+        // Each row of the band crosses a row of thumbnails, computed with their own constant.
+        const int row = y / thumbnailSize;
+        for (int column = 0; column < columns; column++)
+        {
+            FractalParams params  = grid.params;
+            const Float2  complex = GetThumbnailC(grid.centerX, grid.centerY, grid.spacing, column, row);
+            params.complexCX = complex.x;
+            params.complexCY = complex.y;
+
+            FractalKernel  kernel(params, thumbnailSize, thumbnailSize);
+            unsigned char* rowPixels = &grid.pixels[((size_t)y * size + column * thumbnailSize) * 4];
+            for (int x = 0; x < thumbnailSize; x++)
+                colorizer.ColorizePixel(kernel.ComputePixel(x, y % thumbnailSize), rowPixels + x * 4);
+        }
+    }
+    grid.bandsLeft--;
+}
+
+Float2 JuliaAtlas::GetThumbnailC(const double& centerX, const double& centerY, const double& spacing, const int& column, const int& row)
+{
+    return { (float)(centerX + (column - columns / 2) * spacing), (float)(centerY + (row - columns / 2) * spacing) };
+}
@@ -0,0 +1,261 @@
+#include "Minimap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const int Minimap::width;
+const int Minimap::height;
+constexpr double Minimap::scale;
+
+// Size of the blocks of the first pass, in pixels. Must divide bandRows.
+static const int firstBlockSize = 8;
+
+// Rows of each task of a pass.
+static const int bandRows = 8;
+
+// Time spent on the passes each frame on the web, where there are no workers.
+static const std::chrono::microseconds webSliceTime(2000);
+
+// Overviews kept in the cache, the least recently shown ones are unloaded.
+static const size_t maxOverviews = 8;
+
+Minimap::Refinement::Refinement(const FractalParams& _params, const ColorParams& _colorParams, const std::string& _key)
+    : params(_params), colorParams(_colorParams), key(_key), pixels((size_t)width * height * 4, 255),
+      blockSize(firstBlockSize), bandsLeft(0), cancelled(false)
+{
+}
+
+Minimap::Minimap(ThreadPool& _threadPool)
+    : threadPool(_threadPool)
+{
+}
+
+Minimap::~Minimap()
+{
+    Unload();
+}
+
+void Minimap::Unload()
+{
+    if (refinement)
+        refinement->cancelled = true;
+    refinement.reset();
+    for (auto& overview : overviews)
+        UnloadTexture(overview.second.texture);
+    overviews.clear();
+    shownKey.clear();
+}
+
+void Minimap::Show(const std::string& key, const FractalParams& params, const ColorParams& colorParams)
+{
+    if (key == shownKey)
+        return;
+    shownKey = key;
+
+    // Drop the refinement of the previous overview, it is started again from scratch if it is shown again.
+    if (refinement && refinement->key != key) {
+        refinement->cancelled = true;
+        refinement.reset();
+    }
+    auto found = overviews.find(key);
+    if (found != overviews.end())
+    {
+        found->second.lastUse = ++useCount;
+        if (found->second.complete)
+            return;
+    }
+    if (refinement)
+        return;
+
+    FractalParams overviewParams = params;
+    overviewParams.scale      = scale;
+    overviewParams.offsetX    = 0;
+    overviewParams.offsetY    = 0;
+    overviewParams.viewWidth  = width;
+    overviewParams.viewHeight = height;
+    refinement = std::make_shared<Refinement>(overviewParams, colorParams, key);
+}
+
+void Minimap::Update(const bool& idle)
+{
+    if (!refinement)
+        return;
+
+    // The first pass is started at once, the finer ones wait for the view to be still.
+    const bool firstPass = refinement->blockSize == firstBlockSize;
+    if (!refinement->passStarted)
+    {
+        if (!firstPass && !idle)
+            return;
+        StartPass();
+    }
+
+    // Without workers, iterate the samples of the pass for a slice of each frame. The sample being iterated when the
+    // slice runs out is resumed the next frame.
+    #if defined(PLATFORM_WEB)
+        if (firstPass || idle)
+        {
+            FractalKernel kernel(refinement->params, width, height);
+            Colorizer     colorizer(refinement->colorParams);
+            const int     blockSize = refinement->blockSize;
+            const bool passDone = refinement->slicer.Run(IterationSlicer::Clock::now() + webSliceTime,
+                [&](const int& sample, double& x, double& y) -> FractalKernel& {
+                    int pixelX, pixelY;
+                    GetSamplePosition(blockSize, sample, pixelX, pixelY);
+                    x = pixelX + 0.5;
+                    y = pixelY + 0.5;
+                    return kernel;
+                },
+                [&](const int& sample, const FractalSample& result) {
+                    int pixelX, pixelY;
+                    if (!GetSamplePosition(blockSize, sample, pixelX, pixelY))
+                        return;
+                    unsigned char rgba[4];
+                    colorizer.ColorizePixel(result, rgba);
+                    FillBlock(*refinement, pixelX, pixelY, rgba);
+                });
+            if (passDone)
+                refinement->bandsLeft = 0;
+        }
+    #endif
+    if (refinement->bandsLeft > 0)
+        return;
+    FinishPass();
+}
+
+void Minimap::StartPass()
+{
+    const int bandCount = (height + bandRows - 1) / bandRows;
+    refinement->passStarted = true;
+    refinement->bandsLeft   = bandCount;
+    #if defined(PLATFORM_WEB)
+        // The first pass has a sample per block, the next ones three per block of the previous pass.
+        const int blockSize    = refinement->blockSize;
+        const int previousSize = blockSize * 2;
+        if (blockSize == firstBlockSize)
+            refinement->slicer.Restart(((width + blockSize - 1) / blockSize) * ((height + blockSize - 1) / blockSize));
+        else
+            refinement->slicer.Restart(3 * ((width + previousSize - 1) / previousSize) * ((height + previousSize - 1) / previousSize));
+    #else
+        // The overview waits for everything the user is looking at.
+        std::shared_ptr<Refinement> pass = refinement;
+        for (int band = 0; band < bandCount; band++)
+            threadPool.Submit([pass, band]() { ComputeBand(*pass, band); }, TaskPriority::Batch);
+    #endif
+}
+
+void Minimap::FinishPass()
+{
+    // Upload the pass to the overview, which is created with its first pass.
+    Overview& overview = overviews[refinement->key];
+    if (overview.texture.id == 0)
+    {
+        Image image = { refinement->pixels.data(), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        overview.texture = LoadTextureFromImage(image);
+    }
+    else
+    {
+        UpdateTexture(overview.texture, refinement->pixels.data());
+    }
+    overview.lastUse = ++useCount;
+
+    // Halve the blocks for the next pass, until each pixel has its sample.
+    if (refinement->blockSize == 1)
+    {
+        overview.complete = true;
+        refinement.reset();
+    }
+    else
+    {
+        refinement->blockSize  /= 2;
+        refinement->passStarted = false;
+    }
+    Evict();
+}
+
+void Minimap::Evict()
+{
+    while (overviews.size() > maxOverviews)
+    {
+        auto oldest = overviews.end();
+        for (auto it = overviews.begin(); it != overviews.end(); it++)
+            if (it->first != shownKey && (oldest == overviews.end() || it->second.lastUse < oldest->second.lastUse))
+                oldest = it;
+        if (oldest == overviews.end())
+            return;
+        UnloadTexture(oldest->second.texture);
+        overviews.erase(oldest);
+    }
+}
+
+void Minimap::ComputeBand(Refinement& refinement, const int& band)
+{
+    // Each sample fills its block, the samples of the previous passes are at the corners of blocks twice as large.
+    const int  blockSize = refinement.blockSize;
+    const bool firstPass = blockSize == firstBlockSize;
+    const int  endRow    = std::min(height, (band + 1) * bandRows);
+
+    FractalKernel kernel(refinement.params, width, height);
+    Colorizer     colorizer(refinement.colorParams);
+    for (int y = band * bandRows; y < endRow && !refinement.cancelled; y += blockSize)
+    {
+        for (int x = 0; x < width; x += blockSize)
+        {
+            if (!firstPass && x % (2 * blockSize) == 0 && y % (2 * blockSize) == 0)
+                continue;
+
+            unsigned char rgba[4];
+            colorizer.ColorizePixel(kernel.ComputePixel(x, y), rgba);
+            FillBlock(refinement, x, y, rgba);
+        }
+    }
+    refinement.bandsLeft--;
+}
+
+void Minimap::FillBlock(Refinement& refinement, const int& x, const int& y, const unsigned char* rgba)
+{
+    for (int blockY = y; blockY < std::min(height, y + refinement.blockSize); blockY++)
+        for (int blockX = x; blockX < std::min(width, x + refinement.blockSize); blockX++)
+            memcpy(&refinement.pixels[((size_t)blockY * width + blockX) * 4], rgba, 4);
+}
+
+bool Minimap::GetSamplePosition(const int& blockSize, const int& sample, int& x, int& y)
+{
+    // The samples of the first pass are on a grid of blocks. Those of the next ones are at the three corners of the
+    // blocks of the previous pass that don't have a sample yet, some of which are out of the image.
+    if (blockSize == firstBlockSize)
+    {
+        const int columns = (width + blockSize - 1) / blockSize;
+        x = sample % columns * blockSize;
+        y = sample / columns * blockSize;
+    }
+    else
+    {
+        const int previousSize = blockSize * 2;
+        const int columns      = (width + previousSize - 1) / previousSize;
+        const int block        = sample / 3, corner = sample % 3 + 1;
+        x = block % columns * previousSize + (corner & 1) * blockSize;
+        y = block / columns * previousSize + (corner >> 1) * blockSize;
+    }
+    return x < width && y < height;
+}
+
+const Texture2D* Minimap::GetTexture()
+{
+    auto found = overviews.find(shownKey);
+    if (found == overviews.end() || found->second.texture.id == 0)
+        return nullptr;
+    return &found->second.texture;
+}
+
+Float2 Minimap::GetPoint(const Vector2& pixel)
+{
+    const double pixelsPerUnit = 0.5 * pow(2.0, scale) * height;
+    return { (float)((pixel.x - width / 2.0) / pixelsPerUnit), (float)((pixel.y - height / 2.0) / pixelsPerUnit) };
+}
+
+Vector2 Minimap::GetPixel(const Float2& point)
+{
+    const double pixelsPerUnit = 0.5 * pow(2.0, scale) * height;
+    return { (float)(point.x * pixelsPerUnit + width / 2.0), (float)(point.y * pixelsPerUnit + height / 2.0) };
+}
@@ -0,0 +1,208 @@
+#include "PixelReadback.h"
+#include <rlgl.h>
+#if defined(PLATFORM_WEB)
+    #include <GLES2/gl2.h>
+#else
+    #include <external/glad.h>
+#endif
+
+PixelReadback::PixelReadback(const RenderTexture& _target, const int& _chunkRows)
+    : target(_target), chunkRows(_chunkRows)
+{
+    const size_t chunkSize = (size_t)target.texture.width * chunkRows * 4;
+
+    // Pixel buffer objects and fences are only available from OpenGL 3.3.
+    #if defined(PLATFORM_WEB)
+        usePixelBuffers = false;
+    #else
+        usePixelBuffers = rlGetVersion() == RL_OPENGL_33 || rlGetVersion() == RL_OPENGL_43;
+    #endif
+
+    if (!usePixelBuffers) {
+        cpuBuffer.resize(chunkSize);
+        return;
+    }
+
+    #if !defined(PLATFORM_WEB)
+        glGenBuffers(bufferCount, pixelBuffers);
+        for (int i = 0; i < bufferCount; i++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)chunkSize, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    #endif
+}
+
+PixelReadback::~PixelReadback()
+{
+    #if !defined(PLATFORM_WEB)
+        if (!usePixelBuffers) return;
+        for (int i = 0; i < bufferCount; i++)
+            if (fences[i]) glDeleteSync((GLsync)fences[i]);
+        glDeleteBuffers(bufferCount, pixelBuffers);
+    #endif
+}
+
+int PixelReadback::GetChunkRowCount(const int& chunk)
+{
+    int remainingRows = target.texture.height - chunk * chunkRows;
+    return remainingRows < chunkRows ? remainingRows : chunkRows;
+}
+
+void PixelReadback::IssueRead(const int& chunk, const int& slot)
+{
+    #if !defined(PLATFORM_WEB)
+        // Image rows go from top to bottom while framebuffer rows go from bottom to top.
+        const int rowCount = GetChunkRowCount(chunk);
+        const int bottomY  = target.texture.height - chunk * chunkRows - rowCount;
+
+        // Start copying the rows to the pixel buffer, this call returns without waiting for the copy to end.
+        rlEnableFramebuffer(target.id);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+        glReadPixels(0, bottomY, target.texture.width, rowCount, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        rlDisableFramebuffer();
+    #endif
+}
+
+void PixelReadback::ReadSynchronously(const int& chunk, const ReadbackCallback& callback)
+{
+    const int rowCount = GetChunkRowCount(chunk);
+    const int bottomY  = target.texture.height - chunk * chunkRows - rowCount;
+    const int rowSize  = target.texture.width * 4;
+
+    rlEnableFramebuffer(target.id);
+    glReadPixels(0, bottomY, target.texture.width, rowCount, GL_RGBA, GL_UNSIGNED_BYTE, cpuBuffer.data());
+    rlDisableFramebuffer();
+
+    callback(cpuBuffer.data() + (size_t)(rowCount - 1) * rowSize, rowCount, -rowSize);
+}
+
+void PixelReadback::ReadAll(const ReadbackCallback& callback)
+{
+    const int chunkCount = GetChunkCount();
+    if (!usePixelBuffers)
+    {
+        for (int chunk = 0; chunk < chunkCount; chunk++)
+            ReadSynchronously(chunk, callback);
+        return;
+    }
+
+    #if !defined(PLATFORM_WEB)
+        // Queue the first copies.
+        for (int chunk = 0; chunk < bufferCount && chunk < chunkCount; chunk++)
+            IssueRead(chunk, chunk % bufferCount);
+
+        const int rowSize = target.texture.width * 4;
+        for (int chunk = 0; chunk < chunkCount; chunk++)
+        {
+            // Wait for the current chunk only, the next ones keep being copied in the meantime.
+            const int slot     = chunk % bufferCount;
+            const int rowCount = GetChunkRowCount(chunk);
+            GLenum waitResult;
+            do {
+                waitResult = glClientWaitSync((GLsync)fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            } while (waitResult == GL_TIMEOUT_EXPIRED);
+            glDeleteSync((GLsync)fences[slot]);
+            fences[slot] = nullptr;
+
+            // Hand the mapped rows to the callback.
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+            const unsigned char* rows = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)rowSize * rowCount, GL_MAP_READ_BIT);
+            if (waitResult != GL_WAIT_FAILED && rows)
+                callback(rows + (size_t)(rowCount - 1) * rowSize, rowCount, -rowSize);
+            if (rows)
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            // Reuse the buffer for a later chunk.
+            if (chunk + bufferCount < chunkCount)
+                IssueRead(chunk + bufferCount, slot);
+        }
+    #endif
+}
+
+bool PixelReadback::CanStartRead()
+{
+    if (!usePixelBuffers)
+        return !cpuReadPending;
+    for (int slot = 0; slot < bufferCount; slot++)
+        if (!fences[slot])
+            return true;
+    return false;
+}
+
+bool PixelReadback::StartRead(const int& tag)
+{
+    // Without pixel buffers, the rows are read now and handed over by the next collection.
+    if (!usePixelBuffers)
+    {
+        if (cpuReadPending)
+            return false;
+        rlEnableFramebuffer(target.id);
+        glReadPixels(0, 0, target.texture.width, target.texture.height, GL_RGBA, GL_UNSIGNED_BYTE, cpuBuffer.data());
+        rlDisableFramebuffer();
+        readTags[0]    = tag;
+        cpuReadPending = true;
+        return true;
+    }
+
+    for (int slot = 0; slot < bufferCount; slot++) {
+        if (!fences[slot]) {
+            IssueRead(0, slot);
+            readTags[slot] = tag;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PixelReadback::CollectReads(const std::function<void(const int& tag, const unsigned char* firstRow, const int& rowCount, const int& rowStride)>& callback)
+{
+    const int rowCount = GetChunkRowCount(0);
+    const int rowSize  = target.texture.width * 4;
+    if (!usePixelBuffers)
+    {
+        if (cpuReadPending) {
+            cpuReadPending = false;
+            callback(readTags[0], cpuBuffer.data() + (size_t)(rowCount - 1) * rowSize, rowCount, -rowSize);
+        }
+        return;
+    }
+
+    #if !defined(PLATFORM_WEB)
+        for (int slot = 0; slot < bufferCount; slot++)
+        {
+            // Skip the copies the gpu hasn't done yet, they are collected by a later frame.
+            if (!fences[slot])
+                continue;
+            const GLenum waitResult = glClientWaitSync((GLsync)fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (waitResult == GL_TIMEOUT_EXPIRED)
+                continue;
+            glDeleteSync((GLsync)fences[slot]);
+            fences[slot] = nullptr;
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+            const unsigned char* rows = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)rowSize * rowCount, GL_MAP_READ_BIT);
+            if (waitResult != GL_WAIT_FAILED && rows)
+                callback(readTags[slot], rows + (size_t)(rowCount - 1) * rowSize, rowCount, -rowSize);
+            if (rows)
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+    #endif
+}
+
+void PixelReadback::CancelReads()
+{
+    cpuReadPending = false;
+    #if !defined(PLATFORM_WEB)
+        for (int slot = 0; slot < bufferCount; slot++) {
+            if (fences[slot]) {
+                glDeleteSync((GLsync)fences[slot]);
+                fences[slot] = nullptr;
+            }
+        }
+    #endif
+}
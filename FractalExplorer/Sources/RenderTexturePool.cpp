@@ -0,0 +1,113 @@
+#include "RenderTexturePool.h"
+
+RenderTexturePool::RenderTexturePool(const size_t& _maxPooledBytes, const double& _maxIdleTime)
+    : maxPooledBytes(_maxPooledBytes), maxIdleTime(_maxIdleTime), ownerThread(std::this_thread::get_id())
+{
+}
+
+RenderTexturePool::~RenderTexturePool()
+{
+    Trim(0);
+    if (memoryBudget)
+        memoryBudget->Unregister(budgetAccount);
+}
+
+void RenderTexturePool::SetMemoryBudget(MemoryBudget* _memoryBudget, const std::string& accountName)
+{
+    memoryBudget  = _memoryBudget;
+    budgetAccount = memoryBudget->Register(accountName, [this](const size_t& bytes)
+    {
+        if (std::this_thread::get_id() != ownerThread) return;
+        const size_t pooledBytes = GetPooledBytes();
+        Trim(pooledBytes > bytes ? pooledBytes - bytes : 0);
+    });
+}
+
+void RenderTexturePool::Unload(const RenderTexture& renderTexture)
+{
+    UnloadRenderTexture(renderTexture);
+    if (memoryBudget)
+        memoryBudget->Credit(budgetAccount, GetByteSize(renderTexture));
+}
+
+RenderTexture RenderTexturePool::Acquire(const int& width, const int& height)
+{
+    // Reuse a pooled texture of the right size if there is one.
+    for (size_t i = 0; i < pooledTextures.size(); i++)
+    {
+        const RenderTexture& pooled = pooledTextures[i].renderTexture;
+        if (pooled.texture.width == width && pooled.texture.height == height)
+        {
+            RenderTexture renderTexture = pooled;
+            pooledTextures.erase(pooledTextures.begin() + i);
+            return renderTexture;
+        }
+    }
+
+    // Otherwise allocate a new one, freeing the whole pool and retrying if the allocation fails.
+    if (memoryBudget)
+        memoryBudget->MakeRoom(GetByteSize(width, height));
+    RenderTexture renderTexture = LoadRenderTexture(width, height);
+    if (renderTexture.id == 0 && !pooledTextures.empty())
+    {
+        Trim(0);
+        renderTexture = LoadRenderTexture(width, height);
+    }
+    if (memoryBudget && renderTexture.id != 0)
+        memoryBudget->Charge(budgetAccount, GetByteSize(renderTexture));
+    return renderTexture;
+}
+
+void RenderTexturePool::Release(const RenderTexture& renderTexture)
+{
+    if (renderTexture.id == 0) return;
+    pooledTextures.push_back({ renderTexture, GetTime() });
+    Trim(maxPooledBytes);
+}
+
+void RenderTexturePool::Update()
+{
+    // Unload the textures that have not been reused for a while.
+    const double curTime = GetTime();
+    for (size_t i = 0; i < pooledTextures.size(); )
+    {
+        if (curTime - pooledTextures[i].releaseTime > maxIdleTime) {
+            Unload(pooledTextures[i].renderTexture);
+            pooledTextures.erase(pooledTextures.begin() + i);
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+void RenderTexturePool::Trim(const size_t& maxBytes)
+{
+    // Pooled textures are kept in release order, so the least recently released ones are unloaded first.
+    size_t pooledBytes = GetPooledBytes();
+    while (pooledBytes > maxBytes && !pooledTextures.empty())
+    {
+        pooledBytes -= GetByteSize(pooledTextures.front().renderTexture);
+        Unload(pooledTextures.front().renderTexture);
+        pooledTextures.erase(pooledTextures.begin());
+    }
+}
+
+size_t RenderTexturePool::GetPooledBytes()
+{
+    size_t pooledBytes = 0;
+    for (const PooledTexture& pooled : pooledTextures)
+        pooledBytes += GetByteSize(pooled.renderTexture);
+    return pooledBytes;
+}
+
+size_t RenderTexturePool::GetByteSize(const RenderTexture& renderTexture)
+{
+    return GetByteSize(renderTexture.texture.width, renderTexture.texture.height);
+}
+
+size_t RenderTexturePool::GetByteSize(const int& width, const int& height)
+{
+    // RGBA color attachment plus the depth renderbuffer, counted as 4 bytes per pixel.
+    return (size_t)width * height * 8;
+}
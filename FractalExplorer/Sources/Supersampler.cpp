@@ -0,0 +1,163 @@
+#include "Supersampler.h"
+#include <algorithm>
+
+// Rows of each task of a pass.
+static const int bandRows = 16;
+
+// Time spent on the passes each frame on the web, where there are no workers.
+static const std::chrono::microseconds webSliceTime(3000);
+
+// Low-discrepancy sequence, so that the sample positions of the successive passes cover the pixels evenly.
+static double Halton(int index, const int& base)
+{
+    double result = 0, fraction = 1;
+    while (index > 0)
+    {
+        fraction /= base;
+        result   += fraction * (index % base);
+        index    /= base;
+    }
+    return result;
+}
+
+Supersampler::Accumulation::Accumulation(const FractalParams& _params, const ColorParams& _colorParams, const int& _width, const int& _height, MemoryBudget* budget, const int& account)
+    : params(_params), colorParams(_colorParams), width(_width), height(_height),
+      charge(budget, account, (size_t)_width * _height * (3 * sizeof(float) + 4)),
+      sums((size_t)_width * _height * 3, 0.f), pixels((size_t)_width * _height * 4, 255), bandsLeft(0), cancelled(false)
+{
+}
+
+Supersampler::Supersampler(ThreadPool& _threadPool, MemoryBudget* _memoryBudget)
+    : threadPool(_threadPool), memoryBudget(_memoryBudget)
+{
+    budgetAccount = memoryBudget->Register("Supersampling");
+}
+
+Supersampler::~Supersampler()
+{
+    Unload();
+    memoryBudget->Unregister(budgetAccount);
+}
+
+void Supersampler::Unload()
+{
+    Restart();
+    FreeTexture();
+}
+
+void Supersampler::FreeTexture()
+{
+    if (texture.id != 0) {
+        UnloadTexture(texture);
+        memoryBudget->Credit(budgetAccount, (size_t)texture.width * texture.height * 4);
+        texture = {};
+    }
+}
+
+void Supersampler::Restart()
+{
+    if (accumulation)
+        accumulation->cancelled = true;
+    accumulation.reset();
+    sampleCount = 0;
+}
+
+void Supersampler::Update(const FractalParams& params, const ColorParams& colorParams, const int& width, const int& height)
+{
+    if (sampleCount >= maxSamples)
+        return;
+    if (!accumulation)
+    {
+        accumulation = std::make_shared<Accumulation>(params, colorParams, width, height, memoryBudget, budgetAccount);
+        StartPass();
+    }
+
+    // Without workers, iterate the pixels of the pass for a slice of each frame. The pixel being iterated when the
+    // slice runs out is resumed the next frame.
+    #if defined(PLATFORM_WEB)
+        const int     pass = accumulation->passCount - 1;
+        const double  jitterX = pass == 0 ? 0.5 : Halton(pass, 2);
+        const double  jitterY = pass == 0 ? 0.5 : Halton(pass, 3);
+        FractalKernel kernel(accumulation->params, width, height);
+        Colorizer     colorizer(accumulation->colorParams);
+        const bool passDone = accumulation->slicer.Run(IterationSlicer::Clock::now() + webSliceTime,
+            [&](const int& pixel, double& x, double& y) -> FractalKernel& {
+                x = pixel % width + jitterX;
+                y = pixel / width + jitterY;
+                return kernel;
+            },
+            [&](const int& pixel, const FractalSample& sample) {
+                unsigned char rgba[4];
+                colorizer.ColorizePixel(sample, rgba);
+                AddSample(*accumulation, pixel, rgba);
+            });
+        if (passDone)
+            accumulation->bandsLeft = 0;
+    #endif
+    if (accumulation->bandsLeft > 0)
+        return;
+
+    // Show the pass once all its bands are done, then start the next one.
+    if (texture.id != 0 && (texture.width != width || texture.height != height))
+        FreeTexture();
+    if (texture.id == 0)
+    {
+        Image image = { accumulation->pixels.data(), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        texture = LoadTextureFromImage(image);
+        if (texture.id != 0)
+            memoryBudget->Charge(budgetAccount, (size_t)width * height * 4);
+    }
+    else
+    {
+        UpdateTexture(texture, accumulation->pixels.data());
+    }
+    sampleCount = accumulation->passCount;
+    if (sampleCount < maxSamples)
+        StartPass();
+}
+
+void Supersampler::StartPass()
+{
+    const int bandCount = (accumulation->height + bandRows - 1) / bandRows;
+    accumulation->passCount++;
+    accumulation->bandsLeft = bandCount;
+    #if defined(PLATFORM_WEB)
+        accumulation->slicer.Restart(accumulation->width * accumulation->height);
+    #else
+        // Passes are less urgent than the tiles of the view, which preempt them.
+        std::shared_ptr<Accumulation> pass = accumulation;
+        for (int band = 0; band < bandCount; band++)
+            threadPool.Submit([pass, band]() { ComputeBand(*pass, band); }, TaskPriority::Prefetch);
+    #endif
+}
+
+void Supersampler::ComputeBand(Accumulation& accumulation, const int& band)
+{
+    // The first pass samples the pixel centers, the next ones are spread over the pixels.
+    const int    pass    = accumulation.passCount - 1;
+    const double jitterX = pass == 0 ? 0.5 : Halton(pass, 2);
+    const double jitterY = pass == 0 ? 0.5 : Halton(pass, 3);
+    const int    endRow  = std::min(accumulation.height, (band + 1) * bandRows);
+
+    FractalKernel kernel(accumulation.params, accumulation.width, accumulation.height);
+    Colorizer     colorizer(accumulation.colorParams);
+    for (int y = band * bandRows; y < endRow && !accumulation.cancelled; y++)
+    {
+        for (int x = 0; x < accumulation.width; x++)
+        {
+            unsigned char rgba[4];
+            colorizer.ColorizePixel(kernel.ComputeSample(x + jitterX, y + jitterY), rgba);
+            AddSample(accumulation, (size_t)y * accumulation.width + x, rgba);
+        }
+    }
+    accumulation.bandsLeft--;
+}
+
+void Supersampler::AddSample(Accumulation& accumulation, const size_t& pixel, const unsigned char* rgba)
+{
+    float* sum = &accumulation.sums[pixel * 3];
+    for (int channel = 0; channel < 3; channel++) {
+        sum[channel] += rgba[channel];
+        accumulation.pixels[pixel * 4 + channel] = (unsigned char)(sum[channel] / accumulation.passCount + 0.5f);
+    }
+}
@@ -0,0 +1,106 @@
+#include "TileCache.h"
+#include "RenderTexturePool.h"
+#include <cstdio>
+
+const int TileCache::tileSize;
+
+TileCache::TileCache(const size_t& _maxBytes)
+    : maxBytes(_maxBytes), ownerThread(std::this_thread::get_id())
+{
+}
+
+TileCache::~TileCache()
+{
+    Trim(0);
+    if (memoryBudget)
+        memoryBudget->Unregister(budgetAccount);
+}
+
+void TileCache::SetMemoryBudget(MemoryBudget* _memoryBudget, const std::string& accountName)
+{
+    memoryBudget  = _memoryBudget;
+    budgetAccount = memoryBudget->Register(accountName, [this](const size_t& bytes)
+    {
+        if (std::this_thread::get_id() != ownerThread) return;
+        const size_t usedBytes = GetUsedBytes();
+        Trim(usedBytes > bytes ? usedBytes - bytes : 0);
+    });
+}
+
+void TileCache::Unload(const RenderTexture& renderTexture)
+{
+    UnloadRenderTexture(renderTexture);
+    if (memoryBudget)
+        memoryBudget->Credit(budgetAccount, GetTileBytes());
+}
+
+const RenderTexture* TileCache::Find(const std::string& key)
+{
+    auto found = index.find(key);
+    if (found == index.end())
+        return nullptr;
+
+    // Move the tile to the front of the list.
+    tiles.splice(tiles.begin(), tiles, found->second);
+    return &found->second->renderTexture;
+}
+
+RenderTexture TileCache::Add(const std::string& key)
+{
+    RenderTexture renderTexture = {};
+    auto found = index.find(key);
+    if (found != index.end()) {
+        renderTexture = found->second->renderTexture;
+        tiles.erase(found->second);
+        index.erase(found);
+    }
+
+    // Allocate a new tile while the cache has room for it, the budget may unload other tiles to make room.
+    if (renderTexture.id == 0 && GetUsedBytes() + GetTileBytes() <= maxBytes)
+    {
+        if (memoryBudget)
+            memoryBudget->MakeRoom(GetTileBytes());
+        renderTexture = LoadRenderTexture(tileSize, tileSize);
+        if (renderTexture.id != 0) {
+            SetTextureFilter(renderTexture.texture, TEXTURE_FILTER_BILINEAR);
+            if (memoryBudget)
+                memoryBudget->Charge(budgetAccount, GetTileBytes());
+        }
+    }
+
+    // Otherwise reuse the least recently used tile.
+    if (renderTexture.id == 0 && !tiles.empty())
+    {
+        renderTexture = tiles.back().renderTexture;
+        index.erase(tiles.back().key);
+        tiles.pop_back();
+    }
+    if (renderTexture.id == 0)
+        return renderTexture;
+
+    tiles.push_front({ key, renderTexture });
+    index[key] = tiles.begin();
+    return renderTexture;
+}
+
+void TileCache::Trim(const size_t& bytes)
+{
+    while (!tiles.empty() && GetUsedBytes() > bytes)
+    {
+        Unload(tiles.back().renderTexture);
+        index.erase(tiles.back().key);
+        tiles.pop_back();
+    }
+}
+
+std::string TileCache::MakeKey(const std::string& viewKey, const int& level, const long long& x, const long long& y)
+{
+    char tileKey[64];
+    snprintf(tileKey, sizeof(tileKey), " | l%d %lld,%lld", level, x, y);
+    return viewKey + tileKey;
+}
+
+size_t TileCache::GetTileBytes()
+{
+    return RenderTexturePool::GetByteSize(tileSize, tileSize);
+}
@@ -2,6 +2,7 @@
 #include "FractalRenderer.h"
 #include <rlImGui/rlImGui.h>
 #include <algorithm>
+#include <cstdio>
 #if defined PLATFORM_WEB
     #include <emscripten/emscripten.h>
     #include <emscripten/html5.h>
@@ -145,19 +146,81 @@ void Ui::Draw()
                     interactingWithUi = true;
                 }
             }
+            // Views the user stopped at.
+            ViewHistory& history = fractalRenderer.GetHistory();
+            ImGui::AlignTextToFramePadding();
+            ImGui::Text("History:          ");
+            ImGui::SameLine();
+            ImGui::BeginDisabled(!history.CanUndo());
+            if (ImGui::Button("<##undoView")) {
+                fractalRenderer.Undo();
+                interactingWithUi = true;
+            }
+            ImGui::EndDisabled();
+            ImGui::SameLine();
+            ImGui::Text("%d / %d", (int)history.GetPosition() + (history.GetViewCount() > 0), (int)history.GetViewCount());
+            ImGui::SameLine();
+            ImGui::BeginDisabled(!history.CanRedo());
+            if (ImGui::Button(">##redoView")) {
+                fractalRenderer.Redo();
+                interactingWithUi = true;
+            }
+            ImGui::EndDisabled();
+
+            // Target frame time, the view is drawn at a lower resolution while it changes if it can't be ready in time.
+            float targetFrameTime = fractalRenderer.targetFrameTime * 1000;
+            ImGui::AlignTextToFramePadding();
+            ImGui::Text("Frame time:       ");
+            ImGui::SameLine();
+            ImGui::PushItemWidth(70);
+            if (ImGui::DragFloat("##frameTimeInput", &targetFrameTime, 0.1f, 4.f, 100.f, "%.1f ms", ImGuiSliderFlags_AlwaysClamp)) {
+                fractalRenderer.targetFrameTime = targetFrameTime / 1000;
+                interactingWithUi = true;
+            }
+            if (ImGui::IsItemActive()) {
+                interactingWithUi = true;
+            }
+            ImGui::PopItemWidth();
+            if (fractalRenderer.GetResolutionDivisor() > 1) {
+                ImGui::SameLine();
+                ImGui::Text("(1/%d resolution)", fractalRenderer.GetResolutionDivisor());
+            }
+            // Samples per pixel the still view is refined up to.
+            ImGui::AlignTextToFramePadding();
+            ImGui::Text("Idle samples:     ");
+            ImGui::SameLine();
+            ImGui::PushItemWidth(70);
+            if (ImGui::DragInt("##idleSamplesInput", &fractalRenderer.GetMaxIdleSamples(), 0.2f, 0, 256, "%d", ImGuiSliderFlags_AlwaysClamp)) {
+                interactingWithUi = true;
+            }
+            if (ImGui::IsItemActive()) {
+                interactingWithUi = true;
+            }
+            ImGui::PopItemWidth();
+            ImGui::SameLine();
+            ImGui::Text("(%d done)", fractalRenderer.GetIdleSampleCount());
             ImGui::Text("FPS: %d | Delta Time: %.2f", GetFPS(), GetFrameTime());
+
+            // Prefetched tiles that were shown, and those that weren't with the time spent on them.
+            const size_t prefetchHits = fractalRenderer.GetPrefetchHitCount(), prefetchWastes = fractalRenderer.GetPrefetchWasteCount();
+            ImGui::Text("Prefetch: %d%% hits | %d wasted (%.1f s)", prefetchHits + prefetchWastes > 0 ? (int)(100 * prefetchHits / (prefetchHits + prefetchWastes)) : 0,
+                        (int)prefetchWastes, fractalRenderer.GetPrefetchWastedTime());
+            ImGui::Text("Cancelled: %d tiles (%d rows, %.1f s)", (int)fractalRenderer.GetCancelledTileCount(),
+                        (int)fractalRenderer.GetCancelledRowCount(), fractalRenderer.GetCancelledTime());
+            ImGui::Text("Cached tiles: %d | Computing: %d", (int)fractalRenderer.GetCachedTileCount(), (int)fractalRenderer.GetComputingTileCount());
         }
         ImGui::End();
 
         if (ImGui::Begin("Image Saving", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize))
         {
-            // Export scale.
-            float exportScale = fractalRenderer.GetExportScale();
+            // Export scale, deep zoom images are rendered on the cpu and aren't limited by the maximum texture size.
+            float exportScale    = fractalRenderer.GetExportScale();
+            float maxExportScale = fractalRenderer.exportFormat == ExportFormats::DeepZoom ? 64.f : 5.689f;
             ImGui::AlignTextToFramePadding();
             ImGui::Text("Image scale: ");
             ImGui::SameLine();
             ImGui::PushItemWidth(43);
-            if (ImGui::DragFloat("##imageScaleInput", &exportScale, 0.01f, 0.5f, 5.689f, "%.3f", ImGuiSliderFlags_AlwaysClamp)) {
+            if (ImGui::DragFloat("##imageScaleInput", &exportScale, 0.01f, 0.5f, maxExportScale, "%.3f", ImGuiSliderFlags_AlwaysClamp)) {
                 fractalRenderer.SetExportScale(exportScale);
                 interactingWithUi = true;
             }
@@ -165,17 +228,83 @@ void Ui::Draw()
                 interactingWithUi = true;
             }
 
-            // Export button.
+            // Export resolution.
             ImGui::SameLine();
             ImGui::Text("(%dx%d)", (int)(1920 * exportScale), (int)(1080 * exportScale));
             ImGui::PopItemWidth();
-            if (ImGui::Button("Export image")) {
+
+            // Export format.
+            ImGui::AlignTextToFramePadding();
+            ImGui::Text("Format:      ");
+            ImGui::SameLine();
+            int exportFormat = (int)fractalRenderer.exportFormat;
+            ImGui::PushItemWidth(170);
+            #if defined(PLATFORM_WEB)
+                const char* exportFormats = "PNG image\0Raw float data (EXR)\0";
+            #else
+                const char* exportFormats = "PNG image\0Raw float data (EXR)\0Deep zoom tiles (DZI)\0";
+            #endif
+            if (ImGui::Combo("##exportFormatCombo", &exportFormat, exportFormats)) {
+                fractalRenderer.exportFormat = (ExportFormats)exportFormat;
+                if (fractalRenderer.exportFormat != ExportFormats::DeepZoom && exportScale > 5.689f)
+                    fractalRenderer.SetExportScale(5.689f);
+                interactingWithUi = true;
+            }
+            ImGui::PopItemWidth();
+            if (fractalRenderer.exportFormat == ExportFormats::RawFloat) {
+                if (ImGui::Checkbox("ZIP compression", &fractalRenderer.compressRawExport)) {
+                    interactingWithUi = true;
+                }
+            }
+
+            // Memory limit, png exports on the web that don't fit under it are drawn in several bands.
+            int memoryLimit = (int)(fractalRenderer.GetMemoryCeiling() >> 20);
+            ImGui::AlignTextToFramePadding();
+            ImGui::Text("Memory limit:");
+            ImGui::SameLine();
+            ImGui::PushItemWidth(70);
+            if (ImGui::DragInt("##memoryLimitInput", &memoryLimit, 8.f, 128, 16384, "%d MB", ImGuiSliderFlags_AlwaysClamp)) {
+                fractalRenderer.SetMemoryCeiling((size_t)memoryLimit << 20);
+                interactingWithUi = true;
+            }
+            if (ImGui::IsItemActive()) {
+                interactingWithUi = true;
+            }
+            ImGui::SameLine();
+            ImGui::Text("(%.0f MB used)", fractalRenderer.GetUsedMemory() / 1048576.0);
+            ImGui::PopItemWidth();
+
+            // Progress of the deep zoom and raw float exports, which go on in the background. Deep zoom exports can be resumed once cancelled.
+            if (fractalRenderer.IsExporting()) {
+                char progressText[32];
+                snprintf(progressText, sizeof(progressText), "Exporting: %.1f%%", fractalRenderer.GetExportProgress() * 100);
+                ImGui::ProgressBar(fractalRenderer.GetExportProgress(), { 200, 0 }, progressText);
+                ImGui::SameLine();
+                if (ImGui::Button("Cancel")) {
+                    fractalRenderer.CancelExport();
+                    interactingWithUi = true;
+                }
+            }
+
+            // Export button, hidden while an export runs.
+            else if (ImGui::Button("Export image")) {
                 ImGui::AlignTextToFramePadding();
                 ImGui::SameLine();
                 ImGui::Text("Exporting...");
                 fractalRenderer.StartImageExport();
                 interactingWithUi = true;
             }
+
+            // Resume button, for deep zoom exports that were interrupted.
+            if (fractalRenderer.CanResumeExport()) {
+                ImGui::SameLine();
+                if (ImGui::Button("Resume export")) {
+                    ImGui::SameLine();
+                    ImGui::Text("Exporting...");
+                    fractalRenderer.ResumeDeepZoomExport();
+                    interactingWithUi = true;
+                }
+            }
         }
         ImGui::End();
 
@@ -193,6 +322,7 @@ void Ui::Draw()
             ImGui::Text("[ Shift ] to make the complex change slower.");
             ImGui::Text("[ 1 - 3 ] to change the sine automation's duration.");
             ImGui::Text("[ 2 - 5 ] to change the sine automation's amplitude.");
+            ImGui::Text("[Ctrl+Z - Ctrl+Y] to go back and forth between views.");
             ImGui::NewLine();
             ImGui::Text("Use the mouse to move the fractal and the scroll\nwheel to zoom. Right click to center the selected\npoint.");
             ImGui::NewLine();
@@ -200,6 +330,106 @@ void Ui::Draw()
         }
         ImGui::End();
 
+        // Overview of the whole fractal with the part of it that is shown, clicking it moves the view there.
+        ImGui::SetNextWindowPos({ 10, fractalRenderer.GetScreenSize().y - Minimap::height - 50 }, ImGuiCond_Once);
+        if (ImGui::Begin("Minimap", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize))
+        {
+            const Texture2D* minimapTexture = fractalRenderer.GetMinimap().GetTexture();
+            if (minimapTexture)
+            {
+                RLImGuiImage(minimapTexture);
+                const ImVec2 imageMin = ImGui::GetItemRectMin();
+
+                // The view is drawn at least a few pixels wide so that it can still be seen when zoomed in.
+                Vector2 viewMin = Minimap::GetPixel(fractalRenderer.GetViewPoint({ 0, 0 }));
+                Vector2 viewMax = Minimap::GetPixel(fractalRenderer.GetViewPoint(fractalRenderer.GetScreenSize()));
+                const Vector2 viewCenter = { (viewMin.x + viewMax.x) / 2, (viewMin.y + viewMax.y) / 2 };
+                viewMin = { std::min(viewMin.x, viewCenter.x - 2), std::min(viewMin.y, viewCenter.y - 2) };
+                viewMax = { std::max(viewMax.x, viewCenter.x + 2), std::max(viewMax.y, viewCenter.y + 2) };
+                ImGui::PushClipRect(imageMin, ImGui::GetItemRectMax(), true);
+                ImGui::GetWindowDrawList()->AddRect({ imageMin.x + viewMin.x, imageMin.y + viewMin.y }, { imageMin.x + viewMax.x, imageMin.y + viewMax.y }, IM_COL32_WHITE);
+                ImGui::PopClipRect();
+
+                if (ImGui::IsItemHovered() && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+                    const ImVec2 mouse = ImGui::GetMousePos();
+                    const Float2 point = Minimap::GetPoint({ mouse.x - imageMin.x, mouse.y - imageMin.y });
+                    const float  zoom  = (float)pow(2.0, fractalRenderer.scale);
+                    fractalRenderer.offset = { point.x * zoom, point.y * zoom };
+                    fractalRenderer.ValueModifiedThisFrame(ModifiableValues::Offset);
+                    interactingWithUi = true;
+                }
+            }
+            else
+            {
+                ImGui::Dummy({ (float)Minimap::width, (float)Minimap::height });
+            }
+        }
+        ImGui::End();
+
+        // Julia sets of the constants around the cursor (or around the current constant when a julia set is shown),
+        // only computed while the window is open.
+        ImGui::SetNextWindowPos({ fractalRenderer.GetScreenSize().x - 346, fractalRenderer.GetScreenSize().y - 420 }, ImGuiCond_Once);
+        ImGui::SetNextWindowCollapsed(true, ImGuiCond_Once);
+        if (ImGui::Begin("Julia Atlas", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize))
+        {
+            JuliaAtlas& juliaAtlas = fractalRenderer.GetJuliaAtlas();
+            if (fractalRenderer.renderJuliaSet) {
+                atlasCenter = { fractalRenderer.complexC.x, fractalRenderer.complexC.y };
+            }
+            else if (!ImGui::GetIO().WantCaptureMouse) {
+                Float2 cursorPoint = fractalRenderer.GetViewPoint(GetMousePosition());
+                atlasCenter = { cursorPoint.x - 0.125f, cursorPoint.y };
+            }
+            juliaAtlas.Update(fractalRenderer.curFractal, fractalRenderer.GetColorParams(), atlasCenter.x, atlasCenter.y);
+
+            // Spacing between the constants of the thumbnails.
+            ImGui::AlignTextToFramePadding();
+            ImGui::Text("Spacing: ");
+            ImGui::SameLine();
+            ImGui::PushItemWidth(70);
+            if (ImGui::DragFloat("##atlasSpacingInput", &juliaAtlas.spacing, 0.0005f, 0.0001f, 0.5f, "%.4f", ImGuiSliderFlags_AlwaysClamp)) {
+                interactingWithUi = true;
+            }
+            if (ImGui::IsItemActive()) {
+                interactingWithUi = true;
+            }
+            ImGui::PopItemWidth();
+
+            // Clicking a thumbnail shows its julia set.
+            if (juliaAtlas.HasImage())
+            {
+                RLImGuiImage(&juliaAtlas.GetTexture());
+                if (ImGui::IsItemHovered())
+                {
+                    const ImVec2 imageMin = ImGui::GetItemRectMin();
+                    const ImVec2 mouse    = ImGui::GetMousePos();
+                    const int    column   = std::clamp((int)(mouse.x - imageMin.x) / JuliaAtlas::thumbnailSize, 0, JuliaAtlas::columns - 1);
+                    const int    row      = std::clamp((int)(mouse.y - imageMin.y) / JuliaAtlas::thumbnailSize, 0, JuliaAtlas::columns - 1);
+                    const ImVec2 cellMin  = { imageMin.x + column * JuliaAtlas::thumbnailSize, imageMin.y + row * JuliaAtlas::thumbnailSize };
+                    ImGui::GetWindowDrawList()->AddRect(cellMin, { cellMin.x + JuliaAtlas::thumbnailSize, cellMin.y + JuliaAtlas::thumbnailSize }, IM_COL32_WHITE);
+
+                    const Float2 complex = juliaAtlas.GetComplexC(column, row);
+                    ImGui::SetTooltip("%.4f, %.4f", complex.x, complex.y);
+                    if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+                        interactingWithUi = true;
+                    }
+                    if (ImGui::IsItemClicked()) {
+                        fractalRenderer.complexC = complex;
+                        fractalRenderer.ValueModifiedThisFrame(ModifiableValues::Complex);
+                        if (!fractalRenderer.renderJuliaSet) {
+                            fractalRenderer.renderJuliaSet = true;
+                            fractalRenderer.ValueModifiedThisFrame(ModifiableValues::CurFractal);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                ImGui::Text("Computing...");
+            }
+        }
+        ImGui::End();
+
         if (popupOpen) {
             ImGui::SetNextWindowPos({ fractalRenderer.GetScreenSize().x / 2 - 324 / 2, fractalRenderer.GetScreenSize().y / 2 - 212 / 2 }, ImGuiCond_Once);
             if (ImGui::Begin("Notes", NULL, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_AlwaysAutoResize))
@@ -262,6 +492,27 @@ void Ui::ProcessInputs()
             gDownLastFrame = false;
         }
         
+        // Go back and forth in the view history.
+        const bool controlDown = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+        static bool zDownLastFrame = false;
+        if (controlDown && IsKeyDown(KEY_Z)) {
+            if (!zDownLastFrame)
+                fractalRenderer.Undo();
+            zDownLastFrame = true;
+        }
+        else {
+            zDownLastFrame = false;
+        }
+        static bool yDownLastFrame = false;
+        if (controlDown && IsKeyDown(KEY_Y)) {
+            if (!yDownLastFrame)
+                fractalRenderer.Redo();
+            yDownLastFrame = true;
+        }
+        else {
+            yDownLastFrame = false;
+        }
+
         // Show/hide julia sets.
         static bool rDownLastFrame = false;
         if (IsKeyDown(KEY_R)) {
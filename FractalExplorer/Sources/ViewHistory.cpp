@@ -0,0 +1,103 @@
+#include "ViewHistory.h"
+#include <raylib.h>
+
+const size_t ViewHistory::maxViews;
+
+ViewHistory::ViewHistory(ThreadPool& _threadPool, const size_t& maxSnapshotBytes)
+    : threadPool(_threadPool), snapshots(maxSnapshotBytes)
+{
+}
+
+bool ViewHistory::Push(const ViewState& view, const std::string& key)
+{
+    if (!views.empty() && views[current].key == key)
+        return false;
+
+    // The snapshots of the dropped views are left to be evicted from the cache.
+    if (!views.empty())
+        views.erase(views.begin() + current + 1, views.end());
+    views.push_back({ view, key, "s" + std::to_string(snapshotId++), nullptr });
+    if (views.size() > maxViews)
+        views.erase(views.begin());
+    current = views.size() - 1;
+    return true;
+}
+
+void ViewHistory::StoreSnapshot(std::vector<unsigned char>&& pixels, const int& width, const int& height, const double& centerX, const double& centerY, const double& pixelsPerUnit)
+{
+    if (views.empty())
+        return;
+
+    const std::string key = views[current].snapshotKey;
+    #if defined(PLATFORM_WEB)
+        std::shared_ptr<const Snapshot> snapshot = Compress(pixels, width, height, centerX, centerY, pixelsPerUnit);
+        if (snapshot)
+            snapshots.Insert(key, snapshot, snapshot->data.size());
+    #else
+        // Compressing a frame takes a while, so it is done when the workers have nothing else to do.
+        std::shared_ptr<std::vector<unsigned char>> frame = std::make_shared<std::vector<unsigned char>>(std::move(pixels));
+        std::shared_ptr<std::atomic<bool>> compressing = std::make_shared<std::atomic<bool>>(true);
+        views[current].compressing = compressing;
+        threadPool.Submit([this, key, frame, compressing, width, height, centerX, centerY, pixelsPerUnit]()
+        {
+            std::shared_ptr<const Snapshot> snapshot = Compress(*frame, width, height, centerX, centerY, pixelsPerUnit);
+            if (snapshot)
+                snapshots.Insert(key, snapshot, snapshot->data.size());
+            *compressing = false;
+        }, TaskPriority::Batch);
+    #endif
+}
+
+std::shared_ptr<const ViewHistory::Snapshot> ViewHistory::Compress(const std::vector<unsigned char>& pixels, const int& width, const int& height, const double& centerX, const double& centerY, const double& pixelsPerUnit)
+{
+    int compressedSize = 0;
+    unsigned char* compressed = CompressData(pixels.data(), (int)pixels.size(), &compressedSize);
+    if (!compressed)
+        return nullptr;
+
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    snapshot->data.assign(compressed, compressed + compressedSize);
+    snapshot->width         = width;
+    snapshot->height        = height;
+    snapshot->centerX       = centerX;
+    snapshot->centerY       = centerY;
+    snapshot->pixelsPerUnit = pixelsPerUnit;
+    MemFree(compressed);
+    return snapshot;
+}
+
+const ViewState* ViewHistory::GetCurrent()
+{
+    return views.empty() ? nullptr : &views[current].view;
+}
+
+const ViewState* ViewHistory::Undo()
+{
+    if (!CanUndo())
+        return nullptr;
+    return &views[--current].view;
+}
+
+const ViewState* ViewHistory::Redo()
+{
+    if (!CanRedo())
+        return nullptr;
+    return &views[++current].view;
+}
+
+std::shared_ptr<const ViewHistory::Snapshot> ViewHistory::FindSnapshot()
+{
+    if (views.empty())
+        return nullptr;
+    return snapshots.Find(views[current].snapshotKey);
+}
+
+bool ViewHistory::HasSnapshot()
+{
+    return !views.empty() && snapshots.Contains(views[current].snapshotKey);
+}
+
+bool ViewHistory::IsSnapshotPending()
+{
+    return !views.empty() && views[current].compressing && *views[current].compressing;
+}
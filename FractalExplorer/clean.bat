@@ -20,6 +20,13 @@ del Sources\main.o
 del Sources\main.d
 del Sources\Ui.o
 del Sources\Ui.d
+del Sources\PixelReadback.o
+del Sources\PixelReadback.d
+del Sources\RenderTexturePool.o
+del Sources\RenderTexturePool.d
+del ..\FractalCore\Sources\*.web.o
+del ..\FractalCore\Sources\*.web.d
+del ..\FractalCore\libfractalcore-web.a
 del Web\fractalExplorer.html
 del Web\fractalExplorer.js
 del Web\fractalExplorer.wasm
@@ -0,0 +1,77 @@
+#pragma once
+#include "RenderProtocol.h"
+#include "SampleCache.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Hands the tasks of a render to remote workers (fractal-render --worker) and gives their results back in order.
+// Each worker has a thread that keeps a few tasks per worker thread in flight, taking the next task as soon as one
+// comes back, so faster workers get more tasks. Tasks are only handed out a limited distance ahead of the result
+// being waited for, which bounds the memory used by results waiting for their turn.
+// The tasks of a worker whose connection fails are handed to the other workers, and if none is left the remaining
+// tasks are computed locally, by the threads waiting for them. Workers can also freeze without closing their
+// connection, so the tasks of a worker that sends no result for much longer than usual are handed to the other
+// workers as well, whichever answers first wins. A worker that stays silent long after that is given up on.
+class RenderCoordinator
+{
+private:
+    struct Worker
+    {
+        std::string address;
+        Socket      socket;
+        int         threadCount = 0;
+        int         tasksDone   = 0;
+        bool        alive       = false;
+        double      averageInterval = 0; // Seconds between two results while the worker is busy, 0 until known.
+        bool        late            = false; // Its tasks were handed to the others, it stays late until it answers.
+        std::chrono::steady_clock::time_point lastResultTime;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex              mutex;
+    std::condition_variable changed;
+    int                     aliveCount = 0;
+    double                  averageTaskTime = 0; // Seconds a worker thread takes for a task, 0 until known.
+
+    // State of the current render.
+    std::vector<RenderTask>           tasks;
+    std::vector<SampleCache::Samples> results;
+    std::vector<bool>                 done;
+    std::set<int>                     pendingTasks;   // Tasks not handed out yet, in order.
+    int                               doneCount       = 0;
+    int                               firstUnconsumed = 0;
+    int                               lookahead       = 0;
+    int                               retryCount      = 0;
+    bool                              stopping        = false;
+    unsigned int                      firstTaskId     = 0; // Ids of the tasks sent to the workers, unique across renders.
+
+    void ServeWorker(Worker& worker);
+    // Hands the late tasks of a worker to the others. Returns false if the worker should be given up on.
+    bool CheckLateTasks(Worker& worker, const std::map<int, std::chrono::steady_clock::time_point>& inFlight, std::set<int>& handedBack);
+
+public:
+    // Addresses are "host:port" or "host", for the default port.
+    RenderCoordinator(const std::vector<std::string>& addresses);
+    ~RenderCoordinator();
+
+    // Connects to the workers and returns how many answered.
+    int  Connect();
+
+    // Starts handing out the tasks of a render, whose results must then be taken in order with GetResult.
+    void Start(const std::vector<RenderTask>& _tasks);
+    // Waits for the result of the given task, which can only be taken once.
+    SampleCache::Samples GetResult(const int& task);
+    // Ends the current render, the tasks whose results weren't taken are dropped.
+    void Finish();
+
+    // Prints how many tasks each worker did since the connection.
+    void PrintSummary();
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include "FractalKernel.h"
+#include "Socket.h"
+#include <vector>
+
+// Messages exchanged between the render coordinator and its workers. The coordinator opens the connection and
+// sends a hello (magic and version), the worker answers with its own hello and its thread count. The coordinator
+// then sends tasks, and the worker sends back the result of each task as soon as it is computed, in any order.
+// Values are sent in the native byte order, a worker with another byte order fails the hello.
+
+static const unsigned int renderProtocolMagic   = 0x52465846; // "FXFR".
+static const unsigned int renderProtocolVersion = 1;
+static const int          defaultWorkerPort     = 7879;
+static const int          maxTaskIterations     = 1 << 24; // Workers refuse tasks with more, which are rendered locally.
+
+// Region of samples of an image to compute.
+struct RenderTask
+{
+    FractalParams params;
+    int           imageWidth, imageHeight;
+    int           x, y, width, height;
+};
+
+bool SendHello    (Socket& socket, const int& threadCount);
+bool ReceiveHello (Socket& socket, int& threadCount);
+bool SendTask     (Socket& socket, const unsigned int& id, const RenderTask& task);
+bool ReceiveTask  (Socket& socket, unsigned int& id, RenderTask& task);
+bool SendResult   (Socket& socket, const unsigned int& id, const std::vector<FractalSample>& samples);
+bool ReceiveResult(Socket& socket, unsigned int& id, std::vector<FractalSample>& samples);
@@ -0,0 +1,32 @@
+#pragma once
+#include "Scene.h"
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Keeps track of the scenes of a batch render that are done, in a journal file, so that an interrupted batch can be
+// started again with the same command and only render what is left. A scene is done if a scene with the exact same
+// output key (parameters, size, colors and output file) was written, so changing the palette or the resolution of
+// the batch renders it again.
+class RenderQueue
+{
+private:
+    std::string           journalFile;
+    std::set<std::string> doneScenes; // Hashes of the output keys.
+    std::mutex            mutex;
+
+    static std::string GetSceneId(const Scene& scene);
+
+public:
+    RenderQueue(const std::string& _journalFile);
+
+    // Reads the journal, a missing journal is an empty one. Returns false if it exists but can't be read.
+    bool Load();
+    bool IsDone  (const Scene& scene);
+    bool MarkDone(const Scene& scene);
+
+    // Splits the given scenes into groups that are rendered at the same time. Scenes too small to keep all the threads
+    // busy with their tiles are grouped until they have enough tiles between them, large scenes are rendered alone.
+    static std::vector<std::vector<int>> PlanBatches(const std::vector<Scene>& scenes, const std::vector<int>& sceneIndices, const int& threadCount, const int& tileSize);
+};
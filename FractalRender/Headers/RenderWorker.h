@@ -0,0 +1,26 @@
+#pragma once
+#include "DiskSampleCache.h"
+#include "Socket.h"
+#include "ThreadPool.h"
+#include <string>
+
+// Computes the tasks sent by render coordinators (fractal-render --worker). Each coordinator connection has its own
+// thread that receives the tasks and queues them on the thread pool, whose threads send the results back.
+class RenderWorker
+{
+private:
+    ThreadPool&      threadPool;
+    DiskSampleCache* diskCache;
+    Socket           listenSocket;
+
+    void ServeCoordinator(Socket& connection);
+
+public:
+    RenderWorker(ThreadPool& _threadPool, DiskSampleCache* _diskCache = nullptr);
+
+    // Starts listening on the given address and port. Returns false if the socket can't be opened.
+    bool Listen(const std::string& address, const int& port);
+
+    // Accepts coordinators until the server socket fails.
+    void Run();
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include "ViewState.h"
+#include <string>
+#include <vector>
+
+enum class OutputFormats
+{
+    Png,
+    Exr,
+    DeepZoom,
+};
+
+// A view to render and how to render it.
+struct Scene
+{
+    std::string    name;
+    ViewState      view;
+    double         time          = 0;    // Time for the julia constant's sine automation, in seconds.
+    int            width         = 1920;
+    int            height        = 1080;
+    double         viewWidth     = 0;    // Size of the viewport the view was framed in, the image size if 0.
+    double         viewHeight    = 0;
+    int            supersampling = 1;    // Samples per pixel on each axis.
+    int            maxIterations = 500;
+    FloatPrecision precision     = FloatPrecision::Double;
+    std::string    output;               // Output file, its extension (.png, .exr or .dzi) picks the format.
+
+    FractalParams GetFractalParams() const;
+    ColorParams   GetColorParams  () const;
+    OutputFormats GetOutputFormat () const;
+
+    // Returns a key that only depends on what affects the output file, including its name.
+    std::string   GetOutputKey    () const;
+};
+
+// Reads the scenes of a scene file. Scene files are made of "key = value" lines, each "[name]" line starting a new
+// scene. Keys that come before the first scene are defaults for all the scenes of the file.
+// Returns false and describes the problem in error if the file can't be read.
+bool LoadScenes(const std::string& filename, std::vector<Scene>& scenes, std::string& error);
+
+// Applies a "key = value" setting, with the same keys as the scene files, to the given scenes.
+// Returns false and describes the problem in error if the setting is invalid.
+bool ApplySetting(std::vector<Scene>& scenes, const std::string& setting, std::string& error);
@@ -0,0 +1,57 @@
+#pragma once
+#include "DiskSampleCache.h"
+#include "MemoryBudget.h"
+#include "RenderCoordinator.h"
+#include "Scene.h"
+#include "SampleCache.h"
+#include "ThreadPool.h"
+#include <unordered_map>
+
+// Time spent on a scene, in seconds.
+struct SceneTiming
+{
+    bool   success      = false;
+    double renderTime   = 0; // Iterating and coloring.
+    double encodeTime   = 0; // Encoding and writing the output file.
+    double totalTime    = 0;
+    int    tileCount    = 0;
+    int    cachedTiles  = 0; // Tiles whose samples were found in the memory or disk cache.
+    int    remoteTiles  = 0; // Tiles computed by remote workers.
+};
+
+// Renders scenes to files, one strip of tiles at a time. The tiles of a strip are rendered in parallel and their
+// samples are kept in the sample cache, which the scenes of the same run share, and in the disk cache if there is one.
+// With a render coordinator, the png and exr tiles that aren't cached are computed by remote workers instead.
+class SceneRenderer
+{
+private:
+    ThreadPool&        threadPool;
+    SampleCache&       sampleCache;
+    DiskSampleCache*   diskCache;
+    RenderCoordinator* coordinator;
+    int                tileSize;
+    MemoryBudget*      memoryBudget  = nullptr;
+    int                budgetAccount = -1;
+    std::unordered_map<std::string, int> remoteTasks; // Coordinator task of the tiles handed to the workers, by key.
+
+    SampleCache::Samples GetTileSamples(const FractalParams& params, const int& sampleWidth, const int& sampleHeight, const int& x, const int& y, const int& tileWidth, const int& tileHeight, bool& cached, bool& remote);
+    void StartRemoteTiles(const Scene& scene, const int& stripRows);
+    void FinishRemoteTiles();
+    void RenderStrip(const Scene& scene, const int& firstRow, const int& rowCount, unsigned char* rgba, float* channels, SceneTiming& timing);
+
+    bool RenderPng     (const Scene& scene, SceneTiming& timing);
+    bool RenderExr     (const Scene& scene, SceneTiming& timing);
+    bool RenderDeepZoom(const Scene& scene, SceneTiming& timing);
+
+public:
+    SceneRenderer(ThreadPool& _threadPool, SampleCache& _sampleCache, DiskSampleCache* _diskCache = nullptr, RenderCoordinator* _coordinator = nullptr, const int& _tileSize = 256);
+    ~SceneRenderer();
+
+    // Charges the strips being encoded to an account of the given budget.
+    void SetMemoryBudget(MemoryBudget* _memoryBudget);
+
+    TaskPriority priority = TaskPriority::Batch;
+
+    SceneTiming Render(const Scene& scene);
+    int         GetTileSize() { return tileSize; }
+};
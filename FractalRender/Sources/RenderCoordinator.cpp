@@ -0,0 +1,268 @@
+#include "RenderCoordinator.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+using Clock = std::chrono::steady_clock;
+
+// A busy worker sends results at a steady pace, so it is late once it didn't send any for lateFactor times the usual
+// time between two of its results (or, before its first one, the usual time of a task), and never before minLateTime
+// seconds. Its tasks are then handed to the others as well. A worker that stays silent for lostFactor times that
+// long, and never less than minLostTime seconds, is given up on. Before any result came back from any worker, only
+// the connections are watched.
+static const double lateFactor      = 4;
+static const double minLateTime     = 5;
+static const double lostFactor      = 16;
+static const double minLostTime     = 60;
+static const double unknownLostTime = 600;
+
+// A worker that stops in the middle of a message is given up on after this many seconds.
+static const int messageTimeout = 10;
+
+// Time between two looks at the late tasks while waiting for a result, in milliseconds.
+static const int lateCheckInterval = 1000;
+
+// Weight of each new measure in the averages.
+static const double averageWeight = 0.1;
+
+static void UpdateAverage(double& average, const double& value)
+{
+    average = average > 0 ? average + (value - average) * averageWeight : value;
+}
+
+RenderCoordinator::RenderCoordinator(const std::vector<std::string>& addresses)
+{
+    for (const std::string& address : addresses) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->address = address;
+    }
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    Finish();
+}
+
+int RenderCoordinator::Connect()
+{
+    for (auto& worker : workers)
+    {
+        const size_t colon = worker->address.rfind(':');
+        const std::string host = worker->address.substr(0, colon);
+        const int         port = colon == std::string::npos ? defaultWorkerPort : atoi(worker->address.c_str() + colon + 1);
+        worker->socket = Socket::Connect(host, port);
+        if (!worker->socket.IsValid() || !SendHello(worker->socket, 1) || !ReceiveHello(worker->socket, worker->threadCount)) {
+            fprintf(stderr, "fractal-render: can't connect to the worker %s.\n", worker->address.c_str());
+            worker->socket.Close();
+            continue;
+        }
+
+        // Late workers are detected between messages, this only covers a worker that freezes in the middle of one.
+        worker->socket.SetNoDelay();
+        worker->socket.SetReceiveTimeout(messageTimeout);
+        worker->alive = true;
+        aliveCount++;
+    }
+    return aliveCount;
+}
+
+void RenderCoordinator::Start(const std::vector<RenderTask>& _tasks)
+{
+    Finish();
+
+    // Results of the previous render that are still on their way are recognized by their id and dropped.
+    firstTaskId += (unsigned int)tasks.size();
+    tasks = _tasks;
+    results.assign(tasks.size(), nullptr);
+    done.assign(tasks.size(), false);
+    pendingTasks.clear();
+    for (int i = 0; i < (int)tasks.size(); i++)
+        pendingTasks.insert(pendingTasks.end(), i);
+    doneCount       = 0;
+    firstUnconsumed = 0;
+    stopping        = false;
+
+    // Let the workers get twice as many tasks ahead as they can have in flight.
+    lookahead = 0;
+    for (auto& worker : workers)
+        lookahead += worker->alive ? worker->threadCount * 2 : 0;
+    lookahead *= 2;
+
+    for (auto& worker : workers) {
+        Worker* served = worker.get();
+        if (served->alive)
+            served->thread = std::thread([this, served]() { ServeWorker(*served); });
+    }
+}
+
+void RenderCoordinator::ServeWorker(Worker& worker)
+{
+    const int window = worker.threadCount * 2;
+    std::map<int, Clock::time_point> inFlight; // With the time they were sent.
+    std::set<int> handedBack;                 // Late tasks that were also handed to the other workers.
+    std::vector<int> toSend;
+    std::vector<FractalSample> samples;
+    while (true)
+    {
+        // Take the first tasks that are close enough to the one being waited for.
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() {
+                const bool canSend = !stopping && (int)inFlight.size() < window && !pendingTasks.empty()
+                                  && *pendingTasks.begin() < firstUnconsumed + lookahead;
+                return canSend || !inFlight.empty() || stopping || doneCount == (int)tasks.size();
+            });
+            for (auto it = pendingTasks.begin(); !stopping && (int)inFlight.size() < window && it != pendingTasks.end() && *it < firstUnconsumed + lookahead;)
+            {
+                // The tasks this worker is late with are left to the others.
+                if (inFlight.count(*it)) {
+                    it++;
+                    continue;
+                }
+                toSend.push_back(*it);
+                inFlight[*it] = Clock::now();
+                it = pendingTasks.erase(it);
+            }
+            if (inFlight.empty() || stopping)
+                return;
+        }
+        if (toSend.size() == inFlight.size() && !worker.late)
+            worker.lastResultTime = Clock::now(); // The worker had nothing to answer so far.
+
+        // Send them, then wait for a result while watching for late tasks.
+        bool connected = true;
+        for (const int& task : toSend)
+            connected = connected && SendTask(worker.socket, firstTaskId + task, tasks[task]);
+        toSend.clear();
+        while (connected && !worker.socket.WaitForData(lateCheckInterval))
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+                return;
+            connected = CheckLateTasks(worker, inFlight, handedBack);
+        }
+        unsigned int id;
+        connected = connected && ReceiveResult(worker.socket, id, samples);
+
+        // Drop the results of the previous renders.
+        if (connected && id < firstTaskId)
+            continue;
+        const int task = (int)(id - firstTaskId);
+        connected = connected && inFlight.count(task) > 0 && samples.size() == (size_t)tasks[task].width * tasks[task].height;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!connected)
+        {
+            // Hand the tasks of the worker to the others.
+            fprintf(stderr, "fractal-render: lost the worker %s, its %zu tasks will be done again.\n", worker.address.c_str(), inFlight.size());
+            for (const auto& sent : inFlight) {
+                if (!done[sent.first] && !handedBack.count(sent.first)) {
+                    pendingTasks.insert(sent.first);
+                    retryCount++;
+                }
+            }
+            worker.alive = false;
+            worker.socket.Close();
+            aliveCount--;
+            changed.notify_all();
+            return;
+        }
+
+        // Keep track of the pace of the results, to tell when the worker is late.
+        // Its threads work side by side, so each of them takes threadCount intervals for a task.
+        const Clock::time_point now = Clock::now();
+        if (worker.tasksDone > 0) {
+            const double interval = std::chrono::duration<double>(now - worker.lastResultTime).count();
+            UpdateAverage(worker.averageInterval, interval);
+            UpdateAverage(averageTaskTime, interval * worker.threadCount);
+        }
+        worker.lastResultTime = now;
+        worker.late           = false;
+        inFlight.erase(task);
+        handedBack.erase(task);
+        if (!done[task]) {
+            results[task] = std::make_shared<std::vector<FractalSample>>(std::move(samples));
+            done[task]    = true;
+            doneCount++;
+        }
+        worker.tasksDone++;
+        samples.clear();
+        changed.notify_all();
+    }
+}
+
+bool RenderCoordinator::CheckLateTasks(Worker& worker, const std::map<int, Clock::time_point>& inFlight, std::set<int>& handedBack)
+{
+    const double expectedTime = worker.averageInterval > 0 ? worker.averageInterval : averageTaskTime;
+    const double silentTime   = std::chrono::duration<double>(Clock::now() - worker.lastResultTime).count();
+    if (silentTime > (expectedTime > 0 ? std::max(minLostTime, lostFactor * expectedTime) : unknownLostTime))
+        return false;
+    if (expectedTime <= 0 || silentTime <= std::max(minLateTime, lateFactor * expectedTime))
+        return true;
+
+    // The worker keeps its late tasks, in case it answers before the others.
+    worker.late = true;
+    size_t lateCount = 0;
+    for (const auto& sent : inFlight) {
+        if (!done[sent.first] && !handedBack.count(sent.first)) {
+            pendingTasks.insert(sent.first);
+            handedBack.insert(sent.first);
+            lateCount++;
+        }
+    }
+    if (lateCount > 0) {
+        fprintf(stderr, "fractal-render: the worker %s is late, its %zu tasks will also be done by the others.\n", worker.address.c_str(), lateCount);
+        retryCount += (int)lateCount;
+        changed.notify_all();
+    }
+    return true;
+}
+
+SampleCache::Samples RenderCoordinator::GetResult(const int& task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]() { return done[task] || aliveCount == 0; });
+
+    // Without workers, compute the task here unless it is already being computed by another thread.
+    if (!done[task] && pendingTasks.erase(task) > 0)
+    {
+        lock.unlock();
+        const RenderTask& region = tasks[task];
+        FractalKernel kernel(region.params, region.imageWidth, region.imageHeight);
+        auto computed = std::make_shared<std::vector<FractalSample>>((size_t)region.width * region.height);
+        kernel.ComputeRegion(region.x, region.y, region.width, region.height, computed->data());
+        lock.lock();
+        results[task] = computed;
+        done[task]    = true;
+        doneCount++;
+    }
+    changed.wait(lock, [&]() { return done[task]; });
+
+    // Move the lookahead window past the results that were taken.
+    SampleCache::Samples result = results[task];
+    results[task] = nullptr;
+    while (firstUnconsumed < (int)tasks.size() && done[firstUnconsumed] && !results[firstUnconsumed])
+        firstUnconsumed++;
+    changed.notify_all();
+    return result;
+}
+
+void RenderCoordinator::Finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        changed.notify_all();
+    }
+    for (auto& worker : workers)
+        if (worker->thread.joinable())
+            worker->thread.join();
+}
+
+void RenderCoordinator::PrintSummary()
+{
+    for (auto& worker : workers)
+        printf("Worker %s: %d threads, %d tasks%s\n", worker->address.c_str(), worker->threadCount, worker->tasksDone, worker->alive ? "" : " (lost)");
+    if (retryCount > 0)
+        printf("%d tasks were done again after their worker was lost or late.\n", retryCount);
+}
@@ -0,0 +1,129 @@
+#include "RenderProtocol.h"
+#include "BinaryIO.h"
+
+// Tasks and results are the largest regions a task can be, in samples.
+static const size_t maxTaskSamples = (size_t)1 << 24;
+
+// Largest size of each message, so that a peer can't have a large buffer allocated with a bogus size.
+static const size_t maxHelloSize  = 64;
+static const size_t maxTaskSize   = 128;
+static const size_t maxResultSize = maxTaskSamples * sizeof(FractalSample) + 64;
+
+// Messages are sent with their size first.
+static bool SendMessage(Socket& socket, const std::vector<unsigned char>& message)
+{
+    const unsigned int size = (unsigned int)message.size();
+    return socket.SendAll(&size, sizeof(size)) && socket.SendAll(message.data(), message.size());
+}
+
+static bool ReceiveMessage(Socket& socket, std::vector<unsigned char>& message, const size_t& maxSize)
+{
+    unsigned int size;
+    if (!socket.ReceiveAll(&size, sizeof(size)) || size > maxSize)
+        return false;
+    message.resize(size);
+    return socket.ReceiveAll(message.data(), size);
+}
+
+bool SendHello(Socket& socket, const int& threadCount)
+{
+    std::vector<unsigned char> message;
+    PutValue(message, renderProtocolMagic);
+    PutValue(message, renderProtocolVersion);
+    PutValue(message, threadCount);
+    return SendMessage(socket, message);
+}
+
+bool ReceiveHello(Socket& socket, int& threadCount)
+{
+    std::vector<unsigned char> message;
+    unsigned int magic, version;
+    size_t pos = 0;
+    return ReceiveMessage(socket, message, maxHelloSize)
+        && GetValue(message, pos, magic) && magic == renderProtocolMagic
+        && GetValue(message, pos, version) && version == renderProtocolVersion
+        && GetValue(message, pos, threadCount) && threadCount > 0;
+}
+
+bool SendTask(Socket& socket, const unsigned int& id, const RenderTask& task)
+{
+    std::vector<unsigned char> message;
+    PutValue(message, id);
+    PutValue(message, (int)task.params.fractal);
+    PutValue(message, (unsigned char)task.params.juliaSet);
+    PutValue(message, task.params.scale);
+    PutValue(message, task.params.offsetX);
+    PutValue(message, task.params.offsetY);
+    PutValue(message, task.params.complexCX);
+    PutValue(message, task.params.complexCY);
+    PutValue(message, task.params.viewWidth);
+    PutValue(message, task.params.viewHeight);
+    PutValue(message, task.params.maxIterations);
+    PutValue(message, (unsigned char)task.params.precision);
+    PutValue(message, task.imageWidth);
+    PutValue(message, task.imageHeight);
+    PutValue(message, task.x);
+    PutValue(message, task.y);
+    PutValue(message, task.width);
+    PutValue(message, task.height);
+    return SendMessage(socket, message);
+}
+
+bool ReceiveTask(Socket& socket, unsigned int& id, RenderTask& task)
+{
+    std::vector<unsigned char> message;
+    int           fractal;
+    unsigned char juliaSet, precision;
+    size_t        pos = 0;
+    const bool valid = ReceiveMessage(socket, message, maxTaskSize)
+        && GetValue(message, pos, id)
+        && GetValue(message, pos, fractal) && fractal >= 0 && fractal < FRACTAL_COUNT
+        && GetValue(message, pos, juliaSet)
+        && GetValue(message, pos, task.params.scale)
+        && GetValue(message, pos, task.params.offsetX)
+        && GetValue(message, pos, task.params.offsetY)
+        && GetValue(message, pos, task.params.complexCX)
+        && GetValue(message, pos, task.params.complexCY)
+        && GetValue(message, pos, task.params.viewWidth)
+        && GetValue(message, pos, task.params.viewHeight)
+        && GetValue(message, pos, task.params.maxIterations) && task.params.maxIterations > 0 && task.params.maxIterations <= maxTaskIterations
+        && GetValue(message, pos, precision) && precision <= (unsigned char)FloatPrecision::Double
+        && GetValue(message, pos, task.imageWidth)  && task.imageWidth  > 0
+        && GetValue(message, pos, task.imageHeight) && task.imageHeight > 0
+        && GetValue(message, pos, task.x) && task.x >= 0
+        && GetValue(message, pos, task.y) && task.y >= 0
+        && GetValue(message, pos, task.width)
+        && GetValue(message, pos, task.height)
+        && task.width > 0 && task.height > 0 && (size_t)task.width * task.height <= maxTaskSamples
+        && (long long)task.x + task.width <= task.imageWidth && (long long)task.y + task.height <= task.imageHeight
+        && pos == message.size();
+    if (!valid)
+        return false;
+    task.params.fractal   = (FractalTypes)fractal;
+    task.params.juliaSet  = juliaSet != 0;
+    task.params.precision = (FloatPrecision)precision;
+    return true;
+}
+
+bool SendResult(Socket& socket, const unsigned int& id, const std::vector<FractalSample>& samples)
+{
+    std::vector<unsigned char> message;
+    PutValue(message, id);
+    PutValue(message, (unsigned int)samples.size());
+    const unsigned char* bytes = (const unsigned char*)samples.data();
+    message.insert(message.end(), bytes, bytes + samples.size() * sizeof(FractalSample));
+    return SendMessage(socket, message);
+}
+
+bool ReceiveResult(Socket& socket, unsigned int& id, std::vector<FractalSample>& samples)
+{
+    std::vector<unsigned char> message;
+    unsigned int count;
+    size_t pos = 0;
+    if (!ReceiveMessage(socket, message, maxResultSize) || !GetValue(message, pos, id) || !GetValue(message, pos, count)
+     || pos + (size_t)count * sizeof(FractalSample) != message.size())
+        return false;
+    samples.resize(count);
+    memcpy(samples.data(), message.data() + pos, (size_t)count * sizeof(FractalSample));
+    return true;
+}
@@ -0,0 +1,73 @@
+#include "RenderQueue.h"
+#include "SampleCache.h"
+#include <cstdio>
+#include <cstring>
+
+RenderQueue::RenderQueue(const std::string& _journalFile)
+    : journalFile(_journalFile)
+{
+}
+
+std::string RenderQueue::GetSceneId(const Scene& scene)
+{
+    char id[32];
+    snprintf(id, sizeof(id), "%016llx", SampleCache::HashKey(scene.GetOutputKey()));
+    return id;
+}
+
+bool RenderQueue::Load()
+{
+    FILE* file = fopen(journalFile.c_str(), "r");
+    if (!file) {
+        // Create the journal now, so that a journal that can't be written fails before rendering anything.
+        file = fopen(journalFile.c_str(), "a");
+        return file && fclose(file) == 0;
+    }
+
+    // Each line is the id of a scene that was written, then its name. A line cut by a crash is ignored.
+    char line[1024];
+    while (fgets(line, sizeof(line), file))
+    {
+        char id[32];
+        if (sscanf(line, "%31s", id) == 1 && strlen(id) == 16 && strchr(line, '\n'))
+            doneScenes.insert(id);
+    }
+    fclose(file);
+    return true;
+}
+
+bool RenderQueue::IsDone(const Scene& scene)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return doneScenes.count(GetSceneId(scene)) > 0;
+}
+
+bool RenderQueue::MarkDone(const Scene& scene)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::string id = GetSceneId(scene);
+    doneScenes.insert(id);
+
+    FILE* file = fopen(journalFile.c_str(), "a");
+    if (!file) return false;
+    const bool written = fprintf(file, "%s %s\n", id.c_str(), scene.name.c_str()) > 0;
+    return fclose(file) == 0 && written;
+}
+
+std::vector<std::vector<int>> RenderQueue::PlanBatches(const std::vector<Scene>& scenes, const std::vector<int>& sceneIndices, const int& threadCount, const int& tileSize)
+{
+    std::vector<std::vector<int>> batches;
+    int batchTiles = 0;
+    for (const int& index : sceneIndices)
+    {
+        // Scenes are rendered one strip of tiles at a time, so the tiles of a strip are what the threads share.
+        const int stripTiles = (scenes[index].width + tileSize - 1) / tileSize;
+        if (batches.empty() || batchTiles >= threadCount || stripTiles >= threadCount) {
+            batches.emplace_back();
+            batchTiles = 0;
+        }
+        batches.back().push_back(index);
+        batchTiles += stripTiles;
+    }
+    return batches;
+}
@@ -0,0 +1,80 @@
+#include "RenderWorker.h"
+#include "RenderProtocol.h"
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+RenderWorker::RenderWorker(ThreadPool& _threadPool, DiskSampleCache* _diskCache)
+    : threadPool(_threadPool), diskCache(_diskCache)
+{
+}
+
+bool RenderWorker::Listen(const std::string& address, const int& port)
+{
+    listenSocket = Socket::Listen(address, port);
+    return listenSocket.IsValid();
+}
+
+void RenderWorker::Run()
+{
+    while (true)
+    {
+        auto connection = std::make_shared<Socket>(listenSocket.Accept());
+        if (!connection->IsValid())
+            return;
+        std::thread([this, connection]() { ServeCoordinator(*connection); }).detach();
+    }
+}
+
+void RenderWorker::ServeCoordinator(Socket& connection)
+{
+    connection.SetNoDelay();
+    int coordinatorThreads;
+    if (!ReceiveHello(connection, coordinatorThreads) || !SendHello(connection, threadPool.GetThreadCount()))
+        return;
+    printf("Coordinator connected.\n");
+    fflush(stdout);
+
+    // Queue each task on the thread pool. The connection must stay open until the queued tasks are done.
+    std::mutex              mutex;
+    std::condition_variable taskDone;
+    int                     pendingTasks = 0;
+    bool                    failed       = false;
+    int                     taskCount    = 0;
+    unsigned int id;
+    RenderTask   task;
+    while (ReceiveTask(connection, id, task))
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pendingTasks++;
+            taskCount++;
+        }
+        threadPool.Submit([&, id, task]()
+        {
+            // Look for the samples in the disk cache first.
+            const std::string key = diskCache ? SampleCache::MakeKey(task.params, task.imageWidth, task.imageHeight, task.x, task.y, task.width, task.height) : "";
+            SampleCache::Samples samples = diskCache ? diskCache->Find(key) : nullptr;
+            if (!samples) {
+                FractalKernel kernel(task.params, task.imageWidth, task.imageHeight);
+                auto computed = std::make_shared<std::vector<FractalSample>>((size_t)task.width * task.height);
+                kernel.ComputeRegion(task.x, task.y, task.width, task.height, computed->data());
+                if (diskCache)
+                    diskCache->Insert(key, computed);
+                samples = computed;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = failed || !SendResult(connection, id, *samples);
+            pendingTasks--;
+            taskDone.notify_all();
+        }, TaskPriority::Export);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    taskDone.wait(lock, [&]() { return pendingTasks == 0; });
+    printf("Coordinator disconnected after %d tasks.\n", taskCount);
+    fflush(stdout);
+}
@@ -0,0 +1,165 @@
+#include "Scene.h"
+#include "SampleCache.h"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+
+FractalParams Scene::GetFractalParams() const
+{
+    FractalParams params  = view.GetFractalParams(time, viewWidth > 0 ? viewWidth : width, viewHeight > 0 ? viewHeight : height);
+    params.maxIterations  = maxIterations;
+    params.precision      = precision;
+    return params;
+}
+
+ColorParams Scene::GetColorParams() const
+{
+    ColorParams params   = view.GetColorParams();
+    params.maxIterations = maxIterations;
+    return params;
+}
+
+OutputFormats Scene::GetOutputFormat() const
+{
+    auto endsWith = [this](const char* extension) {
+        const std::string ext = extension;
+        return output.size() >= ext.size() && output.compare(output.size() - ext.size(), ext.size(), ext) == 0;
+    };
+    if (endsWith(".exr")) return OutputFormats::Exr;
+    if (endsWith(".dzi")) return OutputFormats::DeepZoom;
+    return OutputFormats::Png;
+}
+
+std::string Scene::GetOutputKey() const
+{
+    const ColorParams colorParams = GetColorParams();
+    char colorKey[128];
+    snprintf(colorKey, sizeof(colorKey), " | h%a,%a z%d | ss%d | ", colorParams.hueFg, colorParams.hueBg, (int)colorParams.colorWithZ, supersampling);
+    return SampleCache::MakeKey(GetFractalParams(), width, height, 0, 0, width, height) + colorKey + output;
+}
+
+// Returns the given string without spaces at its ends.
+static std::string Trim(const std::string& str)
+{
+    size_t start = 0, end = str.size();
+    while (start < end && isspace((unsigned char)str[start]))   start++;
+    while (end > start && isspace((unsigned char)str[end - 1])) end--;
+    return str.substr(start, end - start);
+}
+
+// Returns the lowercase letters and digits of the given string, to compare names loosely.
+static std::string Simplify(const std::string& str)
+{
+    std::string simplified;
+    for (const char& c : str)
+        if (isalnum((unsigned char)c))
+            simplified += (char)tolower((unsigned char)c);
+    return simplified;
+}
+
+static bool ParseFloat2(const std::string& value, Float2& out)
+{
+    return sscanf(value.c_str(), "%f , %f", &out.x, &out.y) == 2;
+}
+
+static bool ParseBool(const std::string& value, bool& out)
+{
+    const std::string simplified = Simplify(value);
+    if (simplified == "true"  || simplified == "yes" || simplified == "1") { out = true;  return true; }
+    if (simplified == "false" || simplified == "no"  || simplified == "0") { out = false; return true; }
+    return false;
+}
+
+// Applies the given key and value to the scene. Returns false if the key is unknown or the value is invalid.
+static bool ApplyValue(Scene& scene, const std::string& key, const std::string& value)
+{
+    const std::string k = Simplify(key);
+    char extra;
+    if (k == "fractal")       return FractalNames::Parse(value.c_str(), scene.view.curFractal);
+    if (k == "julia")         return ParseBool(value, scene.view.renderJuliaSet);
+    if (k == "complexc")      return ParseFloat2(value, scene.view.complexC);
+    if (k == "sineparams")    return ParseFloat2(value, scene.view.sineParams);
+    if (k == "offset")        return ParseFloat2(value, scene.view.offset);
+    if (k == "hues")          return ParseFloat2(value, scene.view.customHue);
+    if (k == "scale")         return sscanf(value.c_str(), "%f %c", &scene.view.scale, &extra) == 1;
+    if (k == "time")          return sscanf(value.c_str(), "%lf %c", &scene.time, &extra) == 1;
+    if (k == "resolution")    return sscanf(value.c_str(), "%d x %d %c", &scene.width, &scene.height, &extra) == 2 && scene.width > 0 && scene.height > 0;
+    if (k == "viewsize")      return sscanf(value.c_str(), "%lf x %lf %c", &scene.viewWidth, &scene.viewHeight, &extra) == 2;
+    if (k == "supersampling") return sscanf(value.c_str(), "%d %c", &scene.supersampling, &extra) == 1 && scene.supersampling >= 1 && scene.supersampling <= 16;
+    if (k == "iterations")    return sscanf(value.c_str(), "%d %c", &scene.maxIterations, &extra) == 1 && scene.maxIterations > 0;
+    if (k == "output")        { scene.output = value; return !value.empty(); }
+    if (k == "colorstyle")
+    {
+        const std::string style = Simplify(value);
+        if (style == "iterations") { scene.view.colorPxWithZ = false; return true; }
+        if (style == "z")          { scene.view.colorPxWithZ = true;  return true; }
+        return false;
+    }
+    if (k == "precision")
+    {
+        const std::string precision = Simplify(value);
+        if (precision == "single" || precision == "float") { scene.precision = FloatPrecision::Single; return true; }
+        if (precision == "double")                          { scene.precision = FloatPrecision::Double; return true; }
+        return false;
+    }
+    return false;
+}
+
+bool LoadScenes(const std::string& filename, std::vector<Scene>& scenes, std::string& error)
+{
+    std::ifstream file(filename);
+    if (!file) {
+        error = "unable to open " + filename;
+        return false;
+    }
+
+    Scene defaults;
+    Scene* current = &defaults;
+    const size_t firstScene = scenes.size();
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        // Skip empty lines and comments.
+        line = Trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';')
+            continue;
+
+        // Start a new scene from the defaults.
+        if (line[0] == '[' && line.back() == ']') {
+            scenes.push_back(defaults);
+            scenes.back().name = Trim(line.substr(1, line.size() - 2));
+            current = &scenes.back();
+            continue;
+        }
+
+        const size_t equal = line.find('=');
+        if (equal == std::string::npos || !ApplyValue(*current, Trim(line.substr(0, equal)), Trim(line.substr(equal + 1)))) {
+            error = filename + ":" + std::to_string(lineNumber) + ": invalid line \"" + line + "\"";
+            return false;
+        }
+    }
+
+    // A file without sections is a single scene named after the file.
+    if (scenes.size() == firstScene) {
+        scenes.push_back(defaults);
+        size_t nameStart = filename.find_last_of("/\\") + 1, nameEnd = filename.find_last_of('.');
+        scenes.back().name = filename.substr(nameStart, nameEnd > nameStart && nameEnd != std::string::npos ? nameEnd - nameStart : std::string::npos);
+    }
+    for (size_t i = firstScene; i < scenes.size(); i++)
+        if (scenes[i].output.empty())
+            scenes[i].output = scenes[i].name + ".png";
+    return true;
+}
+
+bool ApplySetting(std::vector<Scene>& scenes, const std::string& setting, std::string& error)
+{
+    const size_t equal = setting.find('=');
+    for (Scene& scene : scenes)
+    {
+        if (equal == std::string::npos || !ApplyValue(scene, Trim(setting.substr(0, equal)), Trim(setting.substr(equal + 1)))) {
+            error = "invalid setting \"" + setting + "\"";
+            return false;
+        }
+    }
+    return true;
+}
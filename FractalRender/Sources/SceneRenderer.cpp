@@ -0,0 +1,262 @@
+#include "SceneRenderer.h"
+#include "Colorizer.h"
+#include "DeepZoomExporter.h"
+#include "ExrWriter.h"
+#include "PngWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+// Returns the time since the given time point, in seconds.
+static double SecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+SceneRenderer::SceneRenderer(ThreadPool& _threadPool, SampleCache& _sampleCache, DiskSampleCache* _diskCache, RenderCoordinator* _coordinator, const int& _tileSize)
+    : threadPool(_threadPool), sampleCache(_sampleCache), diskCache(_diskCache), coordinator(_coordinator), tileSize(_tileSize)
+{
+}
+
+SceneRenderer::~SceneRenderer()
+{
+    if (memoryBudget)
+        memoryBudget->Unregister(budgetAccount);
+}
+
+void SceneRenderer::SetMemoryBudget(MemoryBudget* _memoryBudget)
+{
+    memoryBudget  = _memoryBudget;
+    budgetAccount = memoryBudget->Register("Strips");
+}
+
+SceneTiming SceneRenderer::Render(const Scene& scene)
+{
+    SceneTiming timing;
+    const auto start = std::chrono::steady_clock::now();
+    switch (scene.GetOutputFormat())
+    {
+        case OutputFormats::Png:      timing.success = RenderPng     (scene, timing); break;
+        case OutputFormats::Exr:      timing.success = RenderExr     (scene, timing); break;
+        case OutputFormats::DeepZoom: timing.success = RenderDeepZoom(scene, timing); break;
+    }
+    timing.totalTime = SecondsSince(start);
+    return timing;
+}
+
+SampleCache::Samples SceneRenderer::GetTileSamples(const FractalParams& params, const int& sampleWidth, const int& sampleHeight, const int& x, const int& y, const int& tileWidth, const int& tileHeight, bool& cached, bool& remote)
+{
+    const std::string key = SampleCache::MakeKey(params, sampleWidth, sampleHeight, x, y, tileWidth, tileHeight);
+
+    // Every tile handed to the workers must be taken from the coordinator, even if it got cached in the meantime.
+    auto remoteTask = remoteTasks.find(key);
+    remote = remoteTask != remoteTasks.end();
+    cached = false;
+    if (remote) {
+        SampleCache::Samples samples = coordinator->GetResult(remoteTask->second);
+        sampleCache.Insert(key, samples);
+        if (diskCache)
+            diskCache->Insert(key, samples);
+        return samples;
+    }
+
+    SampleCache::Samples samples = sampleCache.Find(key);
+    if (!samples && diskCache) {
+        samples = diskCache->Find(key);
+        if (samples)
+            sampleCache.Insert(key, samples);
+    }
+    cached = samples != nullptr;
+    if (cached)
+        return samples;
+
+    FractalKernel kernel(params, sampleWidth, sampleHeight);
+    auto computed = std::make_shared<std::vector<FractalSample>>((size_t)tileWidth * tileHeight);
+    kernel.ComputeRegion(x, y, tileWidth, tileHeight, computed->data());
+    sampleCache.Insert(key, computed);
+    if (diskCache)
+        diskCache->Insert(key, computed);
+    return computed;
+}
+
+void SceneRenderer::RenderStrip(const Scene& scene, const int& firstRow, const int& rowCount, unsigned char* rgba, float* channels, SceneTiming& timing)
+{
+    // With supersampling, the image is iterated at a higher resolution and each block of samples is averaged.
+    const int           ss           = scene.supersampling;
+    const int           sampleWidth  = scene.width * ss, sampleHeight = scene.height * ss;
+    const int           columnCount  = (scene.width + tileSize - 1) / tileSize;
+    const FractalParams params       = scene.GetFractalParams();
+    Colorizer           colorizer(scene.GetColorParams());
+    std::atomic<int>    cachedTiles(0), remoteTiles(0);
+
+    threadPool.ParallelFor(columnCount, [&](int column)
+    {
+        const int firstColumn = column * tileSize;
+        const int tileWidth   = std::min(tileSize, scene.width - firstColumn);
+        bool cached, remote;
+        SampleCache::Samples samples = GetTileSamples(params, sampleWidth, sampleHeight, firstColumn * ss, firstRow * ss, tileWidth * ss, rowCount * ss, cached, remote);
+        cachedTiles += cached;
+        remoteTiles += remote;
+
+        for (int y = 0; y < rowCount; y++)
+        {
+            for (int x = 0; x < tileWidth; x++)
+            {
+                int   colorSum[4]   = { 0 };
+                float channelSum[4] = { 0 };
+                for (int sy = 0; sy < ss; sy++)
+                {
+                    for (int sx = 0; sx < ss; sx++)
+                    {
+                        const FractalSample& sample = (*samples)[(size_t)(y * ss + sy) * tileWidth * ss + x * ss + sx];
+                        if (rgba) {
+                            unsigned char color[4];
+                            colorizer.ColorizePixel(sample, color);
+                            for (int i = 0; i < 4; i++)
+                                colorSum[i] += color[i];
+                        }
+                        if (channels) {
+                            channelSum[0] += sample.iterations;
+                            channelSum[1] += sample.smoothIterations;
+                            channelSum[2] += sample.zRe;
+                            channelSum[3] += sample.zIm;
+                        }
+                    }
+                }
+
+                const size_t pixel = (size_t)y * scene.width + firstColumn + x;
+                for (int i = 0; i < 4; i++) {
+                    if (rgba)     rgba    [pixel * 4 + i] = (unsigned char)((colorSum[i] + ss * ss / 2) / (ss * ss));
+                    if (channels) channels[pixel * 4 + i] = channelSum[i] / (ss * ss);
+                }
+            }
+        }
+    }, priority);
+
+    timing.tileCount   += columnCount;
+    timing.cachedTiles += cachedTiles;
+    timing.remoteTiles += remoteTiles;
+}
+
+void SceneRenderer::StartRemoteTiles(const Scene& scene, const int& stripRows)
+{
+    if (!coordinator || scene.maxIterations > maxTaskIterations)
+        return;
+
+    // List the tiles in the order RenderStrip takes them, leaving out the ones the caches already hold.
+    const int           ss           = scene.supersampling;
+    const int           sampleWidth  = scene.width * ss, sampleHeight = scene.height * ss;
+    const FractalParams params       = scene.GetFractalParams();
+    std::vector<RenderTask> tasks;
+    for (int firstRow = 0; firstRow < scene.height; firstRow += stripRows)
+    {
+        const int rowCount = std::min(stripRows, scene.height - firstRow);
+        for (int firstColumn = 0; firstColumn < scene.width; firstColumn += tileSize)
+        {
+            const int  tileWidth = std::min(tileSize, scene.width - firstColumn);
+            RenderTask task      = { params, sampleWidth, sampleHeight, firstColumn * ss, firstRow * ss, tileWidth * ss, rowCount * ss };
+            const std::string key = SampleCache::MakeKey(params, sampleWidth, sampleHeight, task.x, task.y, task.width, task.height);
+            if (sampleCache.Contains(key) || (diskCache && diskCache->Contains(key)))
+                continue;
+            remoteTasks[key] = (int)tasks.size();
+            tasks.push_back(task);
+        }
+    }
+    coordinator->Start(tasks);
+}
+
+void SceneRenderer::FinishRemoteTiles()
+{
+    if (coordinator)
+        coordinator->Finish();
+    remoteTasks.clear();
+}
+
+bool SceneRenderer::RenderPng(const Scene& scene, SceneTiming& timing)
+{
+    PngWriter png(scene.width, scene.height);
+    if (!png.Open(scene.output.c_str()))
+        return false;
+
+    std::vector<unsigned char> strip((size_t)scene.width * tileSize * 4);
+    ScopedCharge stripCharge(memoryBudget, budgetAccount, strip.size());
+    StartRemoteTiles(scene, tileSize);
+    for (int firstRow = 0; firstRow < scene.height; firstRow += tileSize)
+    {
+        const int rowCount = std::min(tileSize, scene.height - firstRow);
+        auto start = std::chrono::steady_clock::now();
+        RenderStrip(scene, firstRow, rowCount, strip.data(), nullptr, timing);
+        timing.renderTime += SecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        png.WriteRows(strip.data(), rowCount, scene.width * 4);
+        timing.encodeTime += SecondsSince(start);
+    }
+    FinishRemoteTiles();
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool success = png.Close();
+    timing.encodeTime += SecondsSince(start);
+    return success;
+}
+
+bool SceneRenderer::RenderExr(const Scene& scene, SceneTiming& timing)
+{
+    ExrWriter exr(scene.width, scene.height, { "iterations", "smooth", "z.re", "z.im" }, ExrCompression::Zip);
+    if (!exr.Open(scene.output.c_str()))
+        return false;
+
+    // Strips are made of whole exr blocks, which are encoded in parallel and written in order.
+    static_assert(sizeof(FractalSample) == 4 * sizeof(float), "FractalSample must be made of the 4 exported channels.");
+    const int stripRows = tileSize - tileSize % exr.GetLinesPerBlock();
+    std::vector<float> strip((size_t)scene.width * stripRows * 4);
+    ScopedCharge stripCharge(memoryBudget, budgetAccount, strip.size() * sizeof(float));
+    std::vector<std::vector<unsigned char>> encodedBlocks;
+    StartRemoteTiles(scene, stripRows);
+    for (int firstRow = 0; firstRow < scene.height; firstRow += stripRows)
+    {
+        const int rowCount = std::min(stripRows, scene.height - firstRow);
+        auto start = std::chrono::steady_clock::now();
+        RenderStrip(scene, firstRow, rowCount, nullptr, strip.data(), timing);
+        timing.renderTime += SecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        const int firstBlock = firstRow / exr.GetLinesPerBlock();
+        const int blockCount = (rowCount + exr.GetLinesPerBlock() - 1) / exr.GetLinesPerBlock();
+        encodedBlocks.resize(blockCount);
+        threadPool.ParallelFor(blockCount, [&](int i)
+        {
+            const size_t blockOffset = (size_t)i * exr.GetLinesPerBlock() * scene.width * 4;
+            exr.EncodeBlock(firstBlock + i, strip.data() + blockOffset, encodedBlocks[i]);
+        }, priority);
+        for (int i = 0; i < blockCount; i++)
+            exr.WriteBlock(encodedBlocks[i]);
+        timing.encodeTime += SecondsSince(start);
+    }
+    FinishRemoteTiles();
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool success = exr.Close();
+    timing.encodeTime += SecondsSince(start);
+    return success;
+}
+
+bool SceneRenderer::RenderDeepZoom(const Scene& scene, SceneTiming& timing)
+{
+    // The deep zoom exporter renders and encodes its tiles together, and has no supersampling.
+    const std::string name = scene.output.substr(0, scene.output.size() - 4);
+    DeepZoomExporter exporter(scene.GetFractalParams(), scene.GetColorParams(), scene.width, scene.height, threadPool, tileSize);
+    exporter.diskCache = diskCache;
+    exporter.priority  = priority;
+
+    // Resume the scene where an interrupted run left it, unless the scene changed since.
+    if (DeepZoomExporter::HasCheckpoint(name) && !exporter.ResumeCheckpoint(name))
+        fprintf(stderr, "fractal-render: %s.checkpoint doesn't match its scene, rendering it from the start.\n", name.c_str());
+    timing.tileCount = (scene.width + tileSize - 1) / tileSize * (exporter.GetTileRowCount() - exporter.GetTileRowsRendered());
+    const size_t diskHits = diskCache ? diskCache->GetHitCount() : 0;
+    const bool   success  = exporter.Export(name);
+    timing.cachedTiles = diskCache ? (int)(diskCache->GetHitCount() - diskHits) : 0;
+    return success;
+}
@@ -0,0 +1,225 @@
+#include "RenderQueue.h"
+#include "RenderWorker.h"
+#include "Scene.h"
+#include "SceneRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+static void PrintUsage()
+{
+    printf("Usage: fractal-render [options] scene files...\n");
+    printf("       fractal-render --worker [options]\n");
+    printf("Renders the scenes of the given scene files without opening a window, or computes tiles for other\n");
+    printf("fractal-render processes.\n\n");
+    printf("Options:\n");
+    printf("  --threads <count>   Number of render threads (default: one per core).\n");
+    printf("  --cache <megabytes> Size of the sample cache shared by the scenes (default: 512).\n");
+    printf("  --memory <megabytes>\n");
+    printf("                      Ceiling on the memory of the caches and buffers, the sample cache is\n");
+    printf("                      trimmed to stay under it (default: no ceiling).\n");
+    printf("  --disk-cache <dir>  Directory of the sample cache kept between runs (default: %s).\n", DiskSampleCache::GetDefaultDirectory().c_str());
+    printf("  --disk-cache-size <megabytes>\n");
+    printf("                      Size of the disk cache, 0 to disable it (default: 2048).\n");
+    printf("  --set <key=value>   Overrides a scene setting in all the scenes, e.g. --set resolution=3840x2160.\n");
+    printf("  --output-dir <dir>  Directory the relative output files are written to.\n");
+    printf("  --queue <file>      Journal of the scenes already written, which are skipped when the same\n");
+    printf("                      command is run again (after an interruption, for example).\n");
+    printf("  --workers <host:port,...>\n");
+    printf("                      Hands the png and exr tiles to the given workers.\n");
+    printf("  --worker            Computes tiles for the fractal-render processes that connect.\n");
+    printf("  --listen <address:port>\n");
+    printf("                      Where the worker listens (default: 127.0.0.1:%d). Workers have no authentication,\n", defaultWorkerPort);
+    printf("                      only listen on other addresses (0.0.0.0 for all) on trusted networks.\n");
+}
+
+// Splits a comma separated list.
+static std::vector<std::string> SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        if (end > start)
+            items.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return items;
+}
+
+int main(int argc, char** argv)
+{
+    // Parse the command line.
+    int threadCount = -1, cacheMegabytes = 512, diskCacheMegabytes = 2048, memoryMegabytes = 0;
+    std::string diskCacheDirectory = DiskSampleCache::GetDefaultDirectory();
+    std::string listenAddress      = "127.0.0.1:" + std::to_string(defaultWorkerPort);
+    std::string outputDirectory, queueFile;
+    std::vector<std::string> workerAddresses, settings;
+    std::vector<const char*> sceneFiles;
+    bool workerMode = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "--threads")         == 0 && i + 1 < argc) threadCount        = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cache")           == 0 && i + 1 < argc) cacheMegabytes     = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--memory")          == 0 && i + 1 < argc) memoryMegabytes    = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--disk-cache")      == 0 && i + 1 < argc) diskCacheDirectory = argv[++i];
+        else if (strcmp(argv[i], "--disk-cache-size") == 0 && i + 1 < argc) diskCacheMegabytes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--set")             == 0 && i + 1 < argc) settings.push_back(argv[++i]);
+        else if (strcmp(argv[i], "--output-dir")      == 0 && i + 1 < argc) outputDirectory    = argv[++i];
+        else if (strcmp(argv[i], "--queue")           == 0 && i + 1 < argc) queueFile          = argv[++i];
+        else if (strcmp(argv[i], "--workers")         == 0 && i + 1 < argc) workerAddresses    = SplitList(argv[++i]);
+        else if (strcmp(argv[i], "--listen")          == 0 && i + 1 < argc) listenAddress      = argv[++i];
+        else if (strcmp(argv[i], "--worker")          == 0)                 workerMode         = true;
+        else if (argv[i][0] == '-') {
+            PrintUsage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+        else sceneFiles.push_back(argv[i]);
+    }
+    if (sceneFiles.empty() != workerMode) {
+        PrintUsage();
+        return 1;
+    }
+
+    // Load all the scenes first so that a mistake in the last file doesn't show up hours later.
+    std::vector<Scene> scenes;
+    std::string error;
+    for (const char* sceneFile : sceneFiles)
+    {
+        if (!LoadScenes(sceneFile, scenes, error)) {
+            fprintf(stderr, "fractal-render: %s\n", error.c_str());
+            return 1;
+        }
+    }
+    for (const std::string& setting : settings)
+    {
+        if (!ApplySetting(scenes, setting, error)) {
+            fprintf(stderr, "fractal-render: %s\n", error.c_str());
+            return 1;
+        }
+    }
+    std::error_code directoryError;
+    if (!outputDirectory.empty() && !std::filesystem::create_directories(outputDirectory, directoryError) && directoryError) {
+        fprintf(stderr, "fractal-render: can't create %s.\n", outputDirectory.c_str());
+        return 1;
+    }
+    if (!outputDirectory.empty())
+        for (Scene& scene : scenes)
+            if (scene.output[0] != '/' && scene.output[0] != '\\' && scene.output.find(':') == std::string::npos)
+                scene.output = outputDirectory + "/" + scene.output;
+
+    // Leave out the scenes that are already done.
+    RenderQueue queue(queueFile);
+    std::vector<int> pendingScenes;
+    if (!queueFile.empty() && !queue.Load()) {
+        fprintf(stderr, "fractal-render: can't open the queue %s.\n", queueFile.c_str());
+        return 1;
+    }
+    for (int i = 0; i < (int)scenes.size(); i++)
+        if (queueFile.empty() || !queue.IsDone(scenes[i]))
+            pendingScenes.push_back(i);
+    if (pendingScenes.size() < scenes.size())
+        printf("%zu of the %zu scenes are already done.\n", scenes.size() - pendingScenes.size(), scenes.size());
+
+    // All the scenes use the same threads and caches.
+    ThreadPool    threadPool(threadCount);
+    MemoryBudget  memoryBudget((size_t)std::max(memoryMegabytes, 0) << 20);
+    SampleCache   sampleCache((size_t)std::max(cacheMegabytes, 0) << 20);
+    sampleCache.SetMemoryBudget(&memoryBudget, "Sample cache");
+    std::unique_ptr<DiskSampleCache> diskCache;
+    if (diskCacheMegabytes > 0) {
+        diskCache = std::make_unique<DiskSampleCache>(diskCacheDirectory, (size_t)diskCacheMegabytes << 20);
+        if (!diskCache->IsOpen()) {
+            fprintf(stderr, "fractal-render: can't open the disk cache in %s, rendering without it.\n", diskCacheDirectory.c_str());
+            diskCache.reset();
+        }
+    }
+
+    // In worker mode, serve the coordinators until the program is stopped.
+    if (workerMode)
+    {
+        const size_t colon = listenAddress.rfind(':');
+        const int    port  = colon == std::string::npos ? defaultWorkerPort : atoi(listenAddress.c_str() + colon + 1);
+        RenderWorker worker(threadPool, diskCache.get());
+        if (!worker.Listen(listenAddress.substr(0, colon), port)) {
+            fprintf(stderr, "fractal-render: can't listen on %s.\n", listenAddress.c_str());
+            return 1;
+        }
+        printf("Waiting for coordinators on %s with %d threads.\n", listenAddress.c_str(), threadPool.GetThreadCount());
+        fflush(stdout);
+        worker.Run();
+        return 1;
+    }
+
+    std::unique_ptr<RenderCoordinator> coordinator;
+    if (!workerAddresses.empty()) {
+        coordinator = std::make_unique<RenderCoordinator>(workerAddresses);
+        if (coordinator->Connect() == 0) {
+            fprintf(stderr, "fractal-render: no worker answered, rendering locally.\n");
+            coordinator.reset();
+        }
+    }
+    SceneRenderer sceneRenderer(threadPool, sampleCache, diskCache.get(), coordinator.get());
+    sceneRenderer.SetMemoryBudget(&memoryBudget);
+
+    // Large scenes are rendered one after the other with their tiles in parallel, small scenes are rendered several
+    // at a time. Remote workers are handed the tiles of one scene at a time.
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<SceneTiming> timings(scenes.size());
+    auto renderScene = [&](int index)
+    {
+        const Scene& scene = scenes[index];
+        if (scene.supersampling > 1 && scene.GetOutputFormat() == OutputFormats::DeepZoom)
+            fprintf(stderr, "fractal-render: %s: deep zoom images are rendered without supersampling.\n", scene.name.c_str());
+
+        printf("Rendering %s (%dx%d) to %s...\n", scene.name.c_str(), scene.width, scene.height, scene.output.c_str());
+        fflush(stdout);
+        timings[index] = sceneRenderer.Render(scene);
+        if (!timings[index].success)
+            fprintf(stderr, "fractal-render: %s: failed to write %s.\n", scene.name.c_str(), scene.output.c_str());
+        else if (!queueFile.empty() && !queue.MarkDone(scene))
+            fprintf(stderr, "fractal-render: can't write to the queue %s.\n", queueFile.c_str());
+    };
+    const int batchThreads = coordinator ? 1 : threadPool.GetThreadCount();
+    for (const std::vector<int>& batch : RenderQueue::PlanBatches(scenes, pendingScenes, batchThreads, sceneRenderer.GetTileSize()))
+    {
+        if (batch.size() == 1)
+            renderScene(batch[0]);
+        else
+            threadPool.ParallelFor((int)batch.size(), [&](int i) { renderScene(batch[i]); }, TaskPriority::Batch);
+    }
+    const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Print the timing summary. The tiles computed by the workers never go through the sample cache, they count as misses.
+    int    failedCount = 0;
+    size_t remoteTiles = 0;
+    printf("\n%-24s %11s %9s %9s %9s %13s %13s\n", "Scene", "Size", "Total(s)", "Render(s)", "Encode(s)", "Cached tiles", "Remote tiles");
+    for (const int& i : pendingScenes)
+    {
+        const Scene&       scene  = scenes[i];
+        const SceneTiming& timing = timings[i];
+        char size[32];
+        snprintf(size, sizeof(size), "%dx%d", scene.width, scene.height);
+        printf("%-24.24s %11s %9.3f %9.3f %9.3f %6d/%-6d %6d/%-6d%s\n", scene.name.c_str(), size, timing.totalTime, timing.renderTime,
+               timing.encodeTime, timing.cachedTiles, timing.tileCount, timing.remoteTiles, timing.tileCount, timing.success ? "" : " FAILED");
+        failedCount += !timing.success;
+        remoteTiles += timing.remoteTiles;
+    }
+    printf("%zu scenes in %.3fs on %d threads, cache hit rate: %.1f%%\n", pendingScenes.size(), wallTime, threadPool.GetThreadCount(),
+           100.0 * sampleCache.GetHitCount() / std::max<size_t>(sampleCache.GetHitCount() + sampleCache.GetMissCount() + remoteTiles, 1));
+    if (coordinator)
+        coordinator->PrintSummary();
+    if (diskCache)
+        printf("Disk cache: %zu of %zu lookups found, %zu entries, %.1f MB.\n", diskCache->GetHitCount(),
+               diskCache->GetHitCount() + diskCache->GetMissCount(), diskCache->GetEntryCount(), diskCache->GetUsedBytes() / 1048576.0);
+    printf("Memory: %.1f MB at most in caches and buffers, %.1f MB reclaimed, %.1f MB resident.\n", memoryBudget.GetPeakBytes() / 1048576.0,
+           memoryBudget.GetReclaimedBytes() / 1048576.0, MemoryBudget::GetResidentBytes() / 1048576.0);
+
+    return failedCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "CancellationToken.h"
+#include "Socket.h"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct HttpRequest
+{
+    std::string method;
+    std::string path;                         // Without the query string.
+    std::map<std::string, std::string> query; // Decoded query parameters.
+    CancellationToken clientGone;             // Cancelled once the client has closed the connection.
+};
+
+struct HttpResponse
+{
+    int         status      = 200;
+    std::string contentType = "text/plain";
+    std::string cacheControl;
+    std::shared_ptr<const std::vector<unsigned char>> body;
+
+    static HttpResponse Text(const int& status, const std::string& contentType, const std::string& text);
+};
+
+using HttpHandler = std::function<HttpResponse(const HttpRequest&)>;
+
+// Minimal HTTP/1.1 server, for GET requests only. Each connection is served by its own thread, which calls the
+// handler for every request of the connection (connections are kept alive).
+class HttpServer
+{
+private:
+    HttpHandler      handler;
+    Socket           listenSocket;
+    std::atomic<int> connectionCount;
+    int              maxConnections;
+
+    void ServeConnection(Socket& connection);
+
+public:
+    HttpServer(const HttpHandler& _handler, const int& _maxConnections = 256);
+
+    // Starts listening on the given address and port. Returns false if the socket can't be opened.
+    bool Listen(const std::string& address, const int& port);
+
+    // Accepts connections until the server socket fails.
+    void Run();
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include "Colorizer.h"
+#include "DiskSampleCache.h"
+#include "HttpServer.h"
+#include "LruCache.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Answers the http requests for map tiles, /{fractal}/{z}/{x}/{y}.png, in the usual xyz layout: zoom level 0 is
+// one tile covering [-2, 2] x [-2, 2], and each level splits the tiles of the previous one in four.
+// The julia set and colors are chosen with the query: julia=1, c=x,y, hues=fg,bg, style=z, iterations=n.
+// Rendered tiles are kept encoded in a cache, and tiles requested by several clients at once are rendered once.
+// The samples of the tiles are also kept in the disk cache if there is one, so recoloring a tile or restarting the
+// server doesn't iterate it again. Map viewers drop the requests of the tiles that scrolled out of view by closing
+// their connection, so a tile is cancelled as soon as nobody waits for it anymore.
+class TileServer
+{
+private:
+    using Tile = LruCache<std::vector<unsigned char>>::Value;
+
+    struct PendingTile
+    {
+        std::shared_future<Tile> future;
+        int  waiters   = 0;     // Requests waiting for the tile besides the one rendering it.
+        bool abandoned = false; // The tile was cancelled and taken out of the pending tiles.
+    };
+
+    static constexpr int tileSize     = 256;
+    static constexpr int maxZoomLevel = 48; // Past this, double precision can't tell the pixels apart.
+    static constexpr int latencyCount = 4096;
+
+    ThreadPool&      threadPool;
+    DiskSampleCache* diskCache;
+    MemoryBudget*    memoryBudget;
+    int              renderAccount = -1;
+    LruCache<std::vector<unsigned char>> tileCache;
+    std::map<std::string, std::shared_ptr<PendingTile>> pendingTiles; // Tiles being rendered, by cache key.
+    std::mutex  pendingMutex;
+
+    // Statistics, latencies are kept for the last requests only.
+    std::mutex  statsMutex;
+    size_t      requestCount   = 0;
+    size_t      renderedCount  = 0;
+    size_t      coalescedCount = 0;
+    size_t      cancelledCount = 0;
+    size_t      wastedSamples  = 0; // Samples computed for tiles that were cancelled before they were done.
+    size_t      errorCount     = 0;
+    std::vector<double> latencies;
+    size_t      nextLatency    = 0;
+    std::chrono::steady_clock::time_point startTime;
+
+    // On failure, sets the status to 404 for paths that aren't tiles and 400 for invalid parameters.
+    bool         ParseTileRequest(const HttpRequest& request, FractalParams& fractalParams, ColorParams& colorParams, int& errorStatus, std::string& error);
+    Tile         GetTile   (const FractalParams& fractalParams, const ColorParams& colorParams, const CancellationToken& clientGone);
+    Tile         RenderTile(const FractalParams& fractalParams, const ColorParams& colorParams, const std::string& samplesKey, const CancellationToken& cancel);
+    HttpResponse GetStats  ();
+    void         AddLatency(const double& milliseconds);
+
+public:
+    TileServer(ThreadPool& _threadPool, const size_t& cacheBytes, DiskSampleCache* _diskCache = nullptr, MemoryBudget* _memoryBudget = nullptr);
+    ~TileServer();
+
+    HttpResponse HandleRequest(const HttpRequest& request);
+};
@@ -0,0 +1,171 @@
+#include "HttpServer.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+HttpResponse HttpResponse::Text(const int& status, const std::string& contentType, const std::string& text)
+{
+    HttpResponse response;
+    response.status      = status;
+    response.contentType = contentType;
+    response.body        = std::make_shared<const std::vector<unsigned char>>(text.begin(), text.end());
+    return response;
+}
+
+static const char* GetStatusText(const int& status)
+{
+    switch (status)
+    {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 503: return "Service Unavailable";
+        default:  return "Internal Server Error";
+    }
+}
+
+// Decodes the %XX and + escapes of a url component.
+static std::string UrlDecode(const std::string& str)
+{
+    std::string decoded;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        if (str[i] == '%' && i + 2 < str.size()) {
+            decoded += (char)strtol(str.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        }
+        else {
+            decoded += str[i] == '+' ? ' ' : str[i];
+        }
+    }
+    return decoded;
+}
+
+// Parses the request line and headers. Returns false if the request is malformed.
+static bool ParseRequest(const std::string& head, HttpRequest& request, bool& keepAlive)
+{
+    const size_t lineEnd = head.find("\r\n");
+    const std::string requestLine = head.substr(0, lineEnd);
+    const size_t methodEnd = requestLine.find(' ');
+    const size_t targetEnd = requestLine.find(' ', methodEnd + 1);
+    if (methodEnd == std::string::npos || targetEnd == std::string::npos)
+        return false;
+
+    request.method = requestLine.substr(0, methodEnd);
+    const std::string target  = requestLine.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    const std::string version = requestLine.substr(targetEnd + 1);
+
+    // Split the target into the path and the query parameters.
+    const size_t queryStart = target.find('?');
+    request.path = UrlDecode(target.substr(0, queryStart));
+    if (queryStart != std::string::npos)
+    {
+        const std::string query = target.substr(queryStart + 1);
+        size_t start = 0;
+        while (start <= query.size())
+        {
+            size_t end = query.find('&', start);
+            if (end == std::string::npos) end = query.size();
+            const std::string param = query.substr(start, end - start);
+            const size_t equal = param.find('=');
+            if (!param.empty())
+                request.query[UrlDecode(param.substr(0, equal))] = equal == std::string::npos ? "" : UrlDecode(param.substr(equal + 1));
+            start = end + 1;
+        }
+    }
+
+    // HTTP/1.1 connections are kept alive unless the client asks otherwise, HTTP/1.0 ones are closed.
+    std::string lowerHead = head;
+    for (char& c : lowerHead) c = (char)tolower((unsigned char)c);
+    keepAlive = version == "HTTP/1.1" ? lowerHead.find("connection: close") == std::string::npos
+                                      : lowerHead.find("connection: keep-alive") != std::string::npos;
+    return true;
+}
+
+
+HttpServer::HttpServer(const HttpHandler& _handler, const int& _maxConnections)
+    : handler(_handler), connectionCount(0), maxConnections(_maxConnections)
+{
+}
+
+bool HttpServer::Listen(const std::string& address, const int& port)
+{
+    listenSocket = Socket::Listen(address, port);
+    return listenSocket.IsValid();
+}
+
+void HttpServer::Run()
+{
+    while (true)
+    {
+        auto connection = std::make_shared<Socket>(listenSocket.Accept());
+        if (!connection->IsValid())
+            return;
+
+        // Refuse connections past the limit instead of starting more threads.
+        if (connectionCount >= maxConnections) {
+            const char* busy = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            connection->SendAll(busy, strlen(busy));
+            continue;
+        }
+        connectionCount++;
+        std::thread([this, connection]() {
+            ServeConnection(*connection);
+            connectionCount--;
+        }).detach();
+    }
+}
+
+void HttpServer::ServeConnection(Socket& connection)
+{
+    // Idle connections are closed after a while, and responses are sent as soon as they are written.
+    connection.SetReceiveTimeout(30);
+    connection.SetNoDelay();
+
+    std::string received;
+    bool keepAlive = true;
+    while (keepAlive)
+    {
+        // Read until the end of the request headers.
+        size_t headEnd;
+        while ((headEnd = received.find("\r\n\r\n")) == std::string::npos)
+        {
+            char buffer[4096];
+            const int readSize = connection.Receive(buffer, sizeof(buffer));
+            if (readSize <= 0 || received.size() > 65536)
+                return;
+            received.append(buffer, readSize);
+        }
+        const std::string head = received.substr(0, headEnd);
+        received.erase(0, headEnd + 4);
+
+        // Let the handler answer the request.
+        HttpRequest  request;
+        HttpResponse response;
+        if (!ParseRequest(head, request, keepAlive)) {
+            response  = HttpResponse::Text(400, "text/plain", "Malformed request.\n");
+            keepAlive = false;
+        }
+        else if (request.method != "GET") {
+            response = HttpResponse::Text(405, "text/plain", "Only GET requests are supported.\n");
+        }
+        else {
+            request.clientGone = CancellationToken([&connection]() { return connection.IsPeerClosed(); });
+            response = handler(request);
+        }
+
+        const size_t bodySize = response.body ? response.body->size() : 0;
+        char header[512];
+        const int headerSize = snprintf(header, sizeof(header),
+            "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nAccess-Control-Allow-Origin: *\r\n%s%s%sConnection: %s\r\n\r\n",
+            response.status, GetStatusText(response.status), response.contentType.c_str(), bodySize,
+            response.cacheControl.empty() ? "" : "Cache-Control: ", response.cacheControl.c_str(), response.cacheControl.empty() ? "" : "\r\n",
+            keepAlive ? "keep-alive" : "close");
+        if (!connection.SendAll(header, headerSize) || (bodySize > 0 && !connection.SendAll(response.body->data(), bodySize)))
+            return;
+    }
+}
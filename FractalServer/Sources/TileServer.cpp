@@ -0,0 +1,331 @@
+#include "TileServer.h"
+#include "PngWriter.h"
+#include "SampleCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Parses an integer and checks that the whole string was used and that it fits in an int.
+static bool ParseInt(const std::string& str, int& value)
+{
+    char* end;
+    errno = 0;
+    const long parsed = strtol(str.c_str(), &end, 10);
+    if (str.empty() || *end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX)
+        return false;
+    value = (int)parsed;
+    return true;
+}
+
+// Parses a pair of numbers separated by a comma, like "0.25,-0.5".
+static bool ParsePair(const std::string& str, double& x, double& y)
+{
+    char* end;
+    x = strtod(str.c_str(), &end);
+    if (end == str.c_str() || *end != ',')
+        return false;
+    const char* second = end + 1;
+    y = strtod(second, &end);
+    return end != second && *end == '\0' && std::isfinite(x) && std::isfinite(y);
+}
+
+
+TileServer::TileServer(ThreadPool& _threadPool, const size_t& cacheBytes, DiskSampleCache* _diskCache, MemoryBudget* _memoryBudget)
+    : threadPool(_threadPool), diskCache(_diskCache), memoryBudget(_memoryBudget), tileCache(cacheBytes), startTime(std::chrono::steady_clock::now())
+{
+    latencies.reserve(latencyCount);
+    if (memoryBudget) {
+        tileCache.SetMemoryBudget(memoryBudget, "Tile cache");
+        renderAccount = memoryBudget->Register("Tiles being rendered");
+    }
+}
+
+TileServer::~TileServer()
+{
+    if (memoryBudget)
+        memoryBudget->Unregister(renderAccount);
+}
+
+HttpResponse TileServer::HandleRequest(const HttpRequest& request)
+{
+    if (request.path == "/stats")
+        return GetStats();
+
+    const auto start = std::chrono::steady_clock::now();
+    FractalParams fractalParams;
+    ColorParams   colorParams;
+    std::string   error;
+    int           errorStatus = 404;
+    HttpResponse  response;
+    if (!ParseTileRequest(request, fractalParams, colorParams, errorStatus, error)) {
+        response = HttpResponse::Text(errorStatus, "text/plain", error + "\n");
+    }
+    else {
+        response.contentType  = "image/png";
+        response.cacheControl = "public, max-age=86400";
+        response.body         = GetTile(fractalParams, colorParams, request.clientGone);
+        if (!response.body && request.clientGone.IsCancelled())
+            response = HttpResponse::Text(503, "text/plain", "The request was cancelled.\n");
+        else if (!response.body)
+            response = HttpResponse::Text(500, "text/plain", "The tile couldn't be rendered.\n");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        requestCount++;
+        errorCount += response.status != 200 && response.status != 503;
+    }
+    AddLatency(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return response;
+}
+
+bool TileServer::ParseTileRequest(const HttpRequest& request, FractalParams& fractalParams, ColorParams& colorParams, int& errorStatus, std::string& error)
+{
+    errorStatus = 404;
+    // Split the path into /{fractal}/{z}/{x}/{y}.png.
+    std::vector<std::string> parts;
+    size_t start = 1;
+    while (start <= request.path.size() && request.path[0] == '/')
+    {
+        size_t end = request.path.find('/', start);
+        if (end == std::string::npos) end = request.path.size();
+        parts.push_back(request.path.substr(start, end - start));
+        start = end + 1;
+    }
+    const std::string extension = ".png";
+    if (parts.size() != 4 || parts[3].size() <= extension.size()
+     || parts[3].compare(parts[3].size() - extension.size(), extension.size(), extension) != 0) {
+        error = "Tiles are requested as /{fractal}/{z}/{x}/{y}.png.";
+        return false;
+    }
+    parts[3].erase(parts[3].size() - extension.size());
+
+    int z, x, y;
+    if (!FractalNames::Parse(parts[0].c_str(), fractalParams.fractal)) {
+        error = "Unknown fractal: " + parts[0] + ".";
+        return false;
+    }
+    if (!ParseInt(parts[1], z) || !ParseInt(parts[2], x) || !ParseInt(parts[3], y)
+     || z < 0 || z > maxZoomLevel || x < 0 || y < 0 || x >= (1LL << z) || y >= (1LL << z)) {
+        error = "Invalid tile coordinates.";
+        return false;
+    }
+
+    // Read the optional parameters. Invalid ones are the client's mistake, not a missing tile, which it could cache.
+    errorStatus = 400;
+    for (const auto& param : request.query)
+    {
+        const std::string& key = param.first, value = param.second;
+        double first, second;
+        bool valid = true;
+        if (key == "julia") {
+            fractalParams.juliaSet = value == "1" || value == "true";
+            valid = fractalParams.juliaSet || value == "0" || value == "false";
+        }
+        else if (key == "c") {
+            valid = ParsePair(value, fractalParams.complexCX, fractalParams.complexCY);
+        }
+        else if (key == "hues") {
+            valid = ParsePair(value, first, second);
+            colorParams.hueFg = (float)first;
+            colorParams.hueBg = (float)second;
+        }
+        else if (key == "style") {
+            colorParams.colorWithZ = value == "z";
+            valid = colorParams.colorWithZ || value == "iterations";
+        }
+        else if (key == "iterations") {
+            valid = ParseInt(value, fractalParams.maxIterations) && fractalParams.maxIterations > 0 && fractalParams.maxIterations <= 100000;
+            colorParams.maxIterations = fractalParams.maxIterations;
+        }
+        else if (key == "precision") {
+            fractalParams.precision = value == "single" ? FloatPrecision::Single : FloatPrecision::Double;
+            valid = value == "single" || value == "double";
+        }
+        if (!valid) {
+            error = "Invalid value for " + key + ": " + value + ".";
+            return false;
+        }
+    }
+
+    // The view is the tile itself, at zoom level z the tiles are 4 / 2^z wide and the view is magnified by 2^(z-1).
+    const double zoom    = std::pow(2.0, z - 1);
+    const double size    = 4.0 / std::pow(2.0, z);
+    fractalParams.scale      = z - 1;
+    fractalParams.offsetX    = (-2.0 + (x + 0.5) * size) * zoom;
+    fractalParams.offsetY    = (-2.0 + (y + 0.5) * size) * zoom;
+    fractalParams.viewWidth  = tileSize;
+    fractalParams.viewHeight = tileSize;
+    return true;
+}
+
+TileServer::Tile TileServer::GetTile(const FractalParams& fractalParams, const ColorParams& colorParams, const CancellationToken& clientGone)
+{
+    char colorKey[128];
+    snprintf(colorKey, sizeof(colorKey), " | h%a,%a z%d", colorParams.hueFg, colorParams.hueBg, (int)colorParams.colorWithZ);
+    const std::string samplesKey = SampleCache::MakeKey(fractalParams, tileSize, tileSize, 0, 0, tileSize, tileSize);
+    const std::string key        = samplesKey + colorKey;
+    Tile tile = tileCache.Find(key);
+    if (tile)
+        return tile;
+
+    // Wait for the tile if another request is already rendering it, otherwise render it.
+    std::promise<Tile>           promise;
+    std::shared_ptr<PendingTile> pending;
+    bool                         rendering = false;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        auto found = pendingTiles.find(key);
+        if (found != pendingTiles.end()) {
+            pending = found->second;
+            pending->waiters++;
+        }
+        else {
+            pending = std::make_shared<PendingTile>();
+            pending->future   = promise.get_future().share();
+            pendingTiles[key] = pending;
+            rendering = true;
+        }
+    }
+    if (!rendering) {
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            coalescedCount++;
+        }
+        tile = pending->future.get();
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending->waiters--;
+        return tile;
+    }
+
+    // Give up on the tile once its client is gone and nobody else waits for it. The tile is taken out of the pending
+    // tiles at that point, so that a later request for it renders it again instead of waiting for nothing.
+    CancellationToken cancel([&]()
+    {
+        if (!clientGone.IsCancelled())
+            return false;
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (!pending->abandoned && pending->waiters == 0) {
+            pending->abandoned = true;
+            pendingTiles.erase(key);
+        }
+        return pending->abandoned;
+    });
+    tile = RenderTile(fractalParams, colorParams, samplesKey, cancel);
+    if (tile)
+        tileCache.Insert(key, tile, tile->size());
+    promise.set_value(tile);
+    bool abandoned;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        abandoned = pending->abandoned;
+        if (!abandoned)
+            pendingTiles.erase(key);
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        renderedCount  += !abandoned;
+        cancelledCount +=  abandoned;
+    }
+    return tile;
+}
+
+TileServer::Tile TileServer::RenderTile(const FractalParams& fractalParams, const ColorParams& colorParams, const std::string& samplesKey, const CancellationToken& cancel)
+{
+    // Render the samples by bands of rows on the shared threads, unless they are in the disk cache.
+    SampleCache::Samples samples = diskCache ? diskCache->Find(samplesKey) : nullptr;
+    if (!samples)
+    {
+        const int bandRows  = 16;
+        auto computed = std::make_shared<std::vector<FractalSample>>((size_t)tileSize * tileSize);
+        ScopedCharge samplesCharge(memoryBudget, renderAccount, computed->size() * sizeof(FractalSample));
+        std::atomic<int> computedRows(0);
+        threadPool.ParallelFor(tileSize / bandRows, [&](int band)
+        {
+            FractalKernel kernel(fractalParams, tileSize, tileSize);
+            computedRows += kernel.ComputeRows(band * bandRows, bandRows, computed->data() + (size_t)band * bandRows * tileSize, cancel);
+        });
+        if (computedRows < tileSize) {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            wastedSamples += (size_t)computedRows * tileSize;
+            return nullptr;
+        }
+        if (diskCache)
+            diskCache->Insert(samplesKey, computed);
+        samples = computed;
+    }
+
+    std::vector<unsigned char> rgba((size_t)tileSize * tileSize * 4);
+    Colorizer colorizer(colorParams);
+    colorizer.ColorizePixels(samples->data(), (int)samples->size(), rgba.data());
+
+    PngWriter png(tileSize, tileSize);
+    png.OpenInMemory();
+    png.WriteRows(rgba.data(), tileSize, tileSize * 4);
+    if (!png.Close())
+        return nullptr;
+    return std::make_shared<const std::vector<unsigned char>>(png.GetData());
+}
+
+void TileServer::AddLatency(const double& milliseconds)
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    if (latencies.size() < latencyCount)
+        latencies.push_back(milliseconds);
+    else
+        latencies[nextLatency] = milliseconds;
+    nextLatency = (nextLatency + 1) % latencyCount;
+}
+
+HttpResponse TileServer::GetStats()
+{
+    std::vector<double> sortedLatencies;
+    size_t requests, rendered, coalesced, cancelled, wasted, errors;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        sortedLatencies = latencies;
+        requests  = requestCount;
+        rendered  = renderedCount;
+        coalesced = coalescedCount;
+        cancelled = cancelledCount;
+        wasted    = wastedSamples;
+        errors    = errorCount;
+    }
+    std::sort(sortedLatencies.begin(), sortedLatencies.end());
+    auto percentile = [&](const double& p) {
+        return sortedLatencies.empty() ? 0.0 : sortedLatencies[std::min(sortedLatencies.size() - 1, (size_t)(p * sortedLatencies.size()))];
+    };
+
+    const size_t hits    = tileCache.GetHitCount(), misses = tileCache.GetMissCount();
+    const double uptime  = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    char json[2048];
+    snprintf(json, sizeof(json),
+        "{\n"
+        "  \"uptimeSeconds\": %.1f,\n"
+        "  \"requests\": %zu,\n"
+        "  \"errors\": %zu,\n"
+        "  \"cacheHits\": %zu,\n"
+        "  \"cacheMisses\": %zu,\n"
+        "  \"cacheHitRate\": %.4f,\n"
+        "  \"coalescedRequests\": %zu,\n"
+        "  \"renderedTiles\": %zu,\n"
+        "  \"cancelledTiles\": %zu,\n"
+        "  \"wastedSamples\": %zu,\n"
+        "  \"cachedTiles\": %zu,\n"
+        "  \"cacheBytes\": %zu,\n"
+        "  \"diskCacheHits\": %zu,\n"
+        "  \"diskCacheMisses\": %zu,\n"
+        "  \"memory\": { \"usedBytes\": %zu, \"peakBytes\": %zu, \"ceilingBytes\": %zu, \"reclaimedBytes\": %zu, \"residentBytes\": %zu },\n"
+        "  \"latencyMs\": { \"samples\": %zu, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f }\n"
+        "}\n",
+        uptime, requests, errors, hits, misses, hits + misses > 0 ? (double)hits / (hits + misses) : 0.0, coalesced, rendered, cancelled, wasted,
+        tileCache.GetEntryCount(), tileCache.GetUsedBytes(), diskCache ? diskCache->GetHitCount() : 0, diskCache ? diskCache->GetMissCount() : 0,
+        memoryBudget ? memoryBudget->GetUsedBytes() : 0, memoryBudget ? memoryBudget->GetPeakBytes() : 0, memoryBudget ? memoryBudget->GetCeiling() : 0,
+        memoryBudget ? memoryBudget->GetReclaimedBytes() : 0, MemoryBudget::GetResidentBytes(), sortedLatencies.size(),
+        percentile(0.5), percentile(0.9), percentile(0.99), sortedLatencies.empty() ? 0.0 : sortedLatencies.back());
+    return HttpResponse::Text(200, "application/json", json);
+}
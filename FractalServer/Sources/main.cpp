@@ -0,0 +1,68 @@
+#include "HttpServer.h"
+#include "TileServer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+static void PrintUsage()
+{
+    printf("Usage: fractal-server [options]\n");
+    printf("Serves fractal map tiles over http, at /{fractal}/{z}/{x}/{y}.png, and statistics at /stats.\n\n");
+    printf("Options:\n");
+    printf("  --address <ip>      Address to listen on (default: 127.0.0.1).\n");
+    printf("  --port <port>       Port to listen on (default: 8080).\n");
+    printf("  --threads <count>   Number of render threads (default: one per core).\n");
+    printf("  --cache <megabytes> Size of the cache of encoded tiles (default: 256).\n");
+    printf("  --memory <megabytes>\n");
+    printf("                      Ceiling on the memory of the tile cache and the tiles being rendered,\n");
+    printf("                      the cache is trimmed to stay under it (default: no ceiling).\n");
+    printf("  --disk-cache <dir>  Directory of the sample cache kept between runs (default: %s).\n", DiskSampleCache::GetDefaultDirectory().c_str());
+    printf("  --disk-cache-size <megabytes>\n");
+    printf("                      Size of the disk cache, 0 to disable it (default: 2048).\n");
+}
+
+int main(int argc, char** argv)
+{
+    // Parse the command line.
+    std::string address = "127.0.0.1";
+    std::string diskCacheDirectory = DiskSampleCache::GetDefaultDirectory();
+    int port = 8080, threadCount = -1, cacheMegabytes = 256, diskCacheMegabytes = 2048, memoryMegabytes = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "--address")         == 0 && i + 1 < argc) address            = argv[++i];
+        else if (strcmp(argv[i], "--port")            == 0 && i + 1 < argc) port               = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads")         == 0 && i + 1 < argc) threadCount        = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cache")           == 0 && i + 1 < argc) cacheMegabytes     = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--memory")          == 0 && i + 1 < argc) memoryMegabytes    = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--disk-cache")      == 0 && i + 1 < argc) diskCacheDirectory = argv[++i];
+        else if (strcmp(argv[i], "--disk-cache-size") == 0 && i + 1 < argc) diskCacheMegabytes = atoi(argv[++i]);
+        else {
+            PrintUsage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    ThreadPool   threadPool(threadCount);
+    MemoryBudget memoryBudget((size_t)std::max(memoryMegabytes, 0) << 20);
+    std::unique_ptr<DiskSampleCache> diskCache;
+    if (diskCacheMegabytes > 0) {
+        diskCache = std::make_unique<DiskSampleCache>(diskCacheDirectory, (size_t)diskCacheMegabytes << 20);
+        if (!diskCache->IsOpen()) {
+            fprintf(stderr, "fractal-server: can't open the disk cache in %s, serving without it.\n", diskCacheDirectory.c_str());
+            diskCache.reset();
+        }
+    }
+    TileServer tileServer(threadPool, (size_t)std::max(cacheMegabytes, 0) << 20, diskCache.get(), &memoryBudget);
+    HttpServer httpServer([&](const HttpRequest& request) { return tileServer.HandleRequest(request); });
+    if (!httpServer.Listen(address, port)) {
+        fprintf(stderr, "fractal-server: can't listen on %s:%d.\n", address.c_str(), port);
+        return 1;
+    }
+
+    printf("Serving tiles on http://%s:%d/ with %d threads.\n", address.c_str(), port, threadPool.GetThreadCount());
+    fflush(stdout);
+    httpServer.Run();
+    return 0;
+}